@@ -7,8 +7,28 @@
 // Pin definitions
 #define PIN_NEO         PC1           // pin connected to NeoPixels
 #define PIN_KEY         PC4           // pin connected to push button
+#define KEY_TOUCH       0             // 1: touch pad on PIN_KEY instead of button
 
 // NeoPixel definitions
 #define NEO_COUNT       16            // number of NeoPixels
 #define NEO_REFRESH     64            // NeoPixel refresh period in milliseconds
 #define NEO_AUTO_COUNT  76            // number of periods per animation in auto mode
+#define NEO_DIM_MAX     3             // maximum global dimming steps
+#define NEO_DARK        8             // black frames until refresh period is doubled
+
+// Auto-off
+#define AUTO_OFF        30            // minutes without button press until off (0: never)
+
+// Particle system
+#define PART_COUNT      8             // maximum number of simultaneous particles
+
+// Fire simulation
+#define FIRE_COOLING    24            // maximum random cooling per cell and frame
+#define FIRE_SPARKING   160           // chance (0..255) of a new spark per frame
+#define ANIM_PROFILE    0             // 1: measure update cost of particles and fire
+
+// Battery monitor (LIR2032)
+#define BAT_INTERVAL    10000         // battery check interval in ms
+#define BAT_LOW1        3700          // VDD in mV for one dimming step less
+#define BAT_LOW2        3500          // VDD in mV for two dimming steps less
+#define BAT_CUTOFF      3300          // VDD in mV below which device shuts down
@@ -0,0 +1,105 @@
+// ===================================================================================
+// Non-Blocking Button Driver for CH32V003                                    * v1.0 *
+// ===================================================================================
+//
+// Interrupt driven button driver with debounce, long-press and double-click
+// detection. Both edges of the button pin trigger a pin interrupt, which records
+// the SysTick time of the edge and disables itself. A scheduler task takes over
+// the new state right away (leading-edge debounce), checks the pin again after
+// KEY_DEBOUNCE_MS and then enables the interrupt again. The same task detects long
+// presses. Events are put into a small queue together with the time of their
+// edge and the event task is signaled. Nothing blocks while the button is held.
+// With KEY_TOUCH set in config.h, a touch pad on the same pin replaces the button
+// (see touch.h). It is scanned every KEY_SCAN_MS by the driver task instead.
+//
+// Functions available:
+// --------------------
+// KEY_init(timer, task)    init driver, timer: scheduler slot used by the driver,
+//                          task: scheduler slot signaled on events (KEY_NOTASK: none)
+// KEY_get()                get next event from queue (KEY_NONE if empty)
+// KEY_time()               SysTick time of the event last returned by KEY_get()
+// KEY_isPressed()          debounced button state (1: pressed)
+// KEY_ignore()             drop all events until the button has been released
+// KEY_sleep(keep)          standby until button is pressed, keep: pins (PWR_KEEP)
+//                          that keep their configuration in addition to the button
+//
+// KEY_EVT_enable()         let button edges wake the device from standby (WFE)
+// KEY_EVT_disable()        no wake-up event from button
+//
+// Events:
+// -------
+// KEY_PRESS                button pressed
+// KEY_RELEASE              button released
+// KEY_LONG                 button held for KEY_LONG_MS (still pressed)
+// KEY_DOUBLE               button pressed within KEY_DOUBLE_MS after last release
+//                          (follows the KEY_PRESS event of the same press)
+//
+// Notes:
+// ------
+// - Requires the scheduler (sched.h) and defines the pin interrupt routine.
+// - The button must connect the pin to ground (internal pull-up is used).
+// - Scheduler standby (SCHED_STDBY): the button edge ends the standby, so it is
+//   timestamped after the wake-up time of the MCU instead of after the AWU period.
+//   The SysTick counter stops in standby and the interrupted period is not added,
+//   so a release-to-press gap across it is measured too short by the time slept
+//   (less than one standby period, e.g. 128ms in dark stretches of neo_demo). A
+//   double-click can thus be detected up to that much after KEY_DOUBLE_MS. Long
+//   presses are timed correctly, completed standby periods are added.
+// - Touch mode: event times are scan times (resolution KEY_SCAN_MS), the pad is
+//   scanned every KEY_SLEEP_MS during KEY_sleep(). There is no pin interrupt, the
+//   scans keep the scheduler waking up.
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "config.h"
+#include "system.h"
+#include "gpio.h"
+#include "sched.h"
+#include "touch.h"
+
+// ===================================================================================
+// Button Driver Settings
+// ===================================================================================
+#define KEY_PIN           PIN_KEY             // button pin (see config.h)
+#define KEY_DEBOUNCE_MS   10                  // debounce time in ms
+#define KEY_LONG_MS       1000                // long press time in ms
+#define KEY_DOUBLE_MS     300                 // max time between double-click in ms
+#define KEY_QUEUE         4                   // event queue size
+#define KEY_SCAN_MS       25                  // touch mode: scan period in ms
+#define KEY_SLEEP_MS      128                 // touch mode: scan period in KEY_sleep
+
+#ifndef KEY_TOUCH
+#define KEY_TOUCH         0                   // 1: touch pad instead of button
+#endif
+
+// ===================================================================================
+// Button Driver Functions
+// ===================================================================================
+enum{KEY_NONE, KEY_PRESS, KEY_RELEASE, KEY_LONG, KEY_DOUBLE};
+#define KEY_NOTASK        0xFF
+
+#define KEY_BIT           ((uint32_t)1 << ((KEY_PIN) & 7))
+#if KEY_TOUCH > 0
+#define KEY_EVT_enable()
+#define KEY_EVT_disable()
+#else
+#define KEY_EVT_enable()  EXTI->EVENR |=  KEY_BIT
+#define KEY_EVT_disable() EXTI->EVENR &= ~KEY_BIT
+#endif
+
+void     KEY_init(uint8_t timer, uint8_t task); // init button driver
+uint8_t  KEY_get(void);                         // get next event
+uint32_t KEY_time(void);                        // time of last event
+uint8_t  KEY_isPressed(void);                   // debounced button state
+void     KEY_ignore(void);                      // ignore current press
+void     KEY_sleep(uint32_t keep);              // standby until pressed
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,75 @@
+// ===================================================================================
+// Latency Recorder for CH32V003                                              * v1.0 *
+// ===================================================================================
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#include "lat.h"
+
+// Statistics for debug read-out
+volatile LAT_stat_t LAT_stat[LAT_CHANNELS];
+
+#if LAT_ENABLE > 0
+// Start time of last recorded latency and of next LAT_stop() per channel
+static uint32_t LAT_last[LAT_CHANNELS];
+static uint32_t LAT_from[LAT_CHANNELS];
+
+// Latency limits in us
+static const uint16_t LAT_limit[LAT_CHANNELS] = {
+  LAT_LIMIT_WAKE, LAT_LIMIT_DECIDE, LAT_LIMIT_FRAME
+};
+
+// Reset statistics
+void LAT_init(void) {
+  uint8_t i, j;
+  for(i=0; i<LAT_CHANNELS; i++) {
+    LAT_stat[i].min   = 0xFFFFFFFF;
+    LAT_stat[i].max   = 0;
+    LAT_stat[i].sum   = 0;
+    LAT_stat[i].count = 0;
+    LAT_stat[i].limit = (uint32_t)LAT_limit[i] * DLY_US_TIME;
+    for(j=0; j<LAT_BINS; j++) LAT_stat[i].hist[j] = 0;
+    LAT_last[i] = 0;                          // ignore time before first wake-up
+    LAT_from[i] = 0;
+  }
+}
+
+// Record latency since SysTick time start (only once per start time)
+void LAT_record(uint8_t ch, uint32_t start) {
+  uint32_t lat = STK->CNT - start;
+  uint32_t val = lat >> LAT_BIN_SHIFT;
+  uint8_t  bin = 0;
+  volatile LAT_stat_t *stat = &LAT_stat[ch];
+  if(start == LAT_last[ch]) return;
+  LAT_last[ch] = start;
+  if(stat->sum + lat < stat->sum) return;     // stop before sum overflows
+  while(val && (bin < LAT_BINS - 1)) {        // logarithmic histogram bin
+    val >>= 1;
+    bin++;
+  }
+  if(stat->hist[bin] != 0xFFFF) stat->hist[bin]++;
+  if(lat < stat->min) stat->min = lat;
+  if(lat > stat->max) stat->max = lat;
+  stat->sum += lat;
+  stat->count++;
+}
+
+// Set start time for a later LAT_stop()
+void LAT_start(uint8_t ch, uint32_t start) {
+  LAT_from[ch] = start;
+}
+
+// Record latency since time set by LAT_start() (only once per start time)
+void LAT_stop(uint8_t ch) {
+  LAT_record(ch, LAT_from[ch]);
+}
+
+// Get bitmap of channels with samples above their limit
+uint8_t LAT_failed(void) {
+  uint8_t i, result = 0;
+  for(i=0; i<LAT_CHANNELS; i++) {
+    if(LAT_stat[i].count && (LAT_stat[i].max > LAT_stat[i].limit)) result |= 1 << i;
+  }
+  return result;
+}
+#endif
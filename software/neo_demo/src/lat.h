@@ -0,0 +1,91 @@
+// ===================================================================================
+// Latency Recorder for CH32V003                                              * v1.0 *
+// ===================================================================================
+//
+// Records the time between a start timestamp (e.g. the wake-up time of the scheduler
+// or the time of a button edge) and the call of LAT_record() (e.g. right before the
+// first byte is sent to the NeoPixels) over many events. Each measuring channel
+// keeps minimum, maximum, sum and number of samples as well as a histogram with
+// logarithmic bins in the global array LAT_stat, which can be read out with the
+// debugger (address of LAT_stat see .map file, average = sum / count). Samples above
+// the channel's limit are flagged, tools/latency.py evaluates a memory dump of
+// LAT_stat and fails if a limit was exceeded.
+//
+// Functions available:
+// --------------------
+// LAT_init()               reset statistics and set limits of all channels
+// LAT_record(ch, start)    record latency since SysTick time start (once per start)
+// LAT_start(ch, start)     set start time for a later LAT_stop()
+// LAT_stop(ch)             record latency since time set by LAT_start()
+// LAT_failed()             bitmap of channels with samples above their limit
+//
+// Channels:
+// ---------
+// LAT_WAKE                 scheduler wake-up to first NeoPixel byte
+// LAT_DECIDE               button edge to decision of the firmware
+// LAT_FRAME                button edge to first NeoPixel byte of the resulting frame
+//
+// Notes:
+// ------
+// - LAT_record() ignores repeated calls with the same start time, so it can be
+//   placed in a function that is called several times per wake-up. Start time 0
+//   is ignored as well (SCHED_wakeTime() before the first wake-up).
+// - The channel stops recording (all values) once its sum would overflow.
+// - All values are in SysTick ticks (divide by DLY_US_TIME for microseconds).
+//   Histogram bin 0 counts latencies below 2^LAT_BIN_SHIFT ticks, each further bin
+//   doubles the range, the last bin counts everything above.
+// - Set LAT_ENABLE to 0 to remove the instrumentation (about 30 cycles per call).
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "system.h"
+
+// ===================================================================================
+// Latency Recorder Settings
+// ===================================================================================
+#define LAT_ENABLE        1                   // 1: record latencies
+#define LAT_BINS          8                   // number of histogram bins
+#define LAT_BIN_SHIFT     6                   // bin 0: below 64 ticks (8us at 8MHz)
+#define LAT_LIMIT_WAKE    1000                // limit wake-up to first byte in us
+#define LAT_LIMIT_DECIDE  1000                // limit button edge to decision in us
+#define LAT_LIMIT_FRAME   2000                // limit button edge to frame in us
+
+// ===================================================================================
+// Latency Recorder Functions
+// ===================================================================================
+enum{LAT_WAKE, LAT_DECIDE, LAT_FRAME, LAT_CHANNELS};
+
+typedef struct {
+  uint32_t min;                               // minimum latency in ticks
+  uint32_t max;                               // maximum latency in ticks
+  uint32_t sum;                               // sum of all latencies in ticks
+  uint32_t count;                             // number of recorded latencies
+  uint32_t limit;                             // maximum allowed latency in ticks
+  uint16_t hist[LAT_BINS];                    // histogram (saturates at 0xFFFF)
+} LAT_stat_t;
+
+extern volatile LAT_stat_t LAT_stat[LAT_CHANNELS];  // statistics for debug read-out
+
+#if LAT_ENABLE > 0
+void    LAT_init(void);                       // reset statistics
+void    LAT_record(uint8_t ch, uint32_t start); // record latency since start
+void    LAT_start(uint8_t ch, uint32_t start);  // set start time for LAT_stop()
+void    LAT_stop(uint8_t ch);                 // record latency since LAT_start()
+uint8_t LAT_failed(void);                     // channels above limit
+#else
+#define LAT_init()
+#define LAT_record(ch, start)
+#define LAT_start(ch, start)
+#define LAT_stop(ch)
+#define LAT_failed()      0
+#endif
+
+#ifdef __cplusplus
+};
+#endif
@@ -12,8 +12,10 @@
 // ------------
 // Various decorative light animations using the TinyBling's NeoPixels.
 // The device automatically switches between the various animations after a defined 
-// time interval. However, if the button is held down during power-up, the switching 
-// occurs with each button press.
+// time interval. However, if the button is held down during power-up, the device
+// toggles to button mode, in which the switching occurs with each button press.
+// Holding the button for a second changes the brightness. Mode, brightness and the
+// animation selected by button are stored in flash and restored on power-up.
 //
 // References:
 // -----------
@@ -36,6 +38,12 @@
 #include <config.h>             // user configurations
 #include <system.h>             // system functions
 #include <gpio.h>               // GPIO functions
+#include <wave.h>               // waveform functions
+#include <store.h>              // flash record store
+#include <sched.h>              // task scheduler
+#include <lat.h>                // latency recorder
+#include <key.h>                // button driver
+#include <tmr.h>                // timer wheel
 
 // ===================================================================================
 // NeoPixel Functions
@@ -44,6 +52,10 @@
 // NeoPixel buffer
 uint8_t NEO_hue[NEO_COUNT];
 uint8_t NEO_bright[NEO_COUNT];
+uint8_t NEO_start = 0;            // buffer index of first pixel (rotation offset)
+uint8_t NEO_dim   = 0;            // global dimming steps (0 = full brightness)
+uint8_t NEO_derate = 0;           // additional dimming steps on low battery
+uint8_t NEO_black = 0;            // 1: pixels show an all-black frame
 
 // Gamma correction table
 const uint8_t NEO_gamma[] = {
@@ -67,7 +79,8 @@ const uint8_t NEO_gamma[] = {
 // ensured that interrupts are disabled and that the time between the 
 // transmission of the individual bytes is less than the pixel's latch time.
 
-// Send one data byte to the pixels string (works at 8MHz CPU frequency)
+// Send one data byte to the pixels string (works at 8MHz CPU frequency, the clock
+// must be switched back with CLK_slow() before transmitting)
 void NEO_sendByte(uint8_t data) {
   asm volatile(
     " c.li a5, 8                \n"   // 8 bits to shift out (bit counter)
@@ -101,35 +114,97 @@ void NEO_writeColor(uint8_t r, uint8_t g, uint8_t b) {
   NEO_sendByte(g); NEO_sendByte(r); NEO_sendByte(b);
 }
 
-// Write buffer to pixels
-void NEO_show(void) {
+// Write a single buffer entry to the next pixel
+void NEO_writePixel(uint8_t i) {
+  uint8_t shift = 6 - NEO_bright[i] + NEO_dim + NEO_derate;
+  if(shift > 6) shift = 6;
+  uint8_t phase = NEO_hue[i] >> 6;
+  uint8_t step  = NEO_hue[i] & 63;
+  uint8_t col   = NEO_gamma[step >> shift];
+  uint8_t ncol  = NEO_gamma[(63 - step) >> shift];
+  switch(phase) {
+    case 0:   NEO_writeColor(ncol,  col,     0); break;
+    case 1:   NEO_writeColor(    0, ncol,  col); break;
+    case 2:   NEO_writeColor( col,     0, ncol); break;
+    default:  break;
+  }
+}
+
+// Check if all buffer entries are too dark to produce any light. A pixel is black
+// if its gamma-corrected channels are all 0, i.e. if 63 >> shift < 7 (shift >= 4).
+uint8_t NEO_isBlack(void) {
+  uint8_t limit = NEO_dim + NEO_derate + 2;
   for(uint8_t i=0; i<NEO_COUNT; i++) {
-    uint8_t phase = NEO_hue[i] >> 6;
-    uint8_t step  = NEO_hue[i] & 63;
-    uint8_t col   = NEO_gamma[step >> (6 - NEO_bright[i])];
-    uint8_t ncol  = NEO_gamma[(63 - step) >> (6 - NEO_bright[i])];
-    switch(phase) {
-      case 0:   NEO_writeColor(ncol,  col,     0); break;
-      case 1:   NEO_writeColor(    0, ncol,  col); break;
-      case 2:   NEO_writeColor( col,     0, ncol); break;
-      default:  break;
-    }
+    if(NEO_bright[i] > limit) return 0;
+  }
+  return 1;
+}
+
+// Write buffer to pixels, starting with the buffer entry at the rotation offset.
+// Only the transmission is skipped if the frame is black and a black frame is
+// already latched; the animation has rendered the frame and NEO_isBlack() still
+// scans the whole buffer for it.
+void NEO_show(void) {
+  uint8_t i;
+  if(NEO_isBlack()) {
+    if(NEO_black) return;
+    NEO_black = 1;
   }
+  else NEO_black = 0;
+  INT_ATOMIC_BLOCK {
+    LAT_record(LAT_WAKE, SCHED_wakeTime()); // wake-up to first byte latency
+    for(i=NEO_start; i<NEO_COUNT; i++) NEO_writePixel(i);
+    for(i=0; i<NEO_start; i++) NEO_writePixel(i);
+  }
+  SYS_bootFrame();                // first frame after reset
 }
 
-// Init NeoPixel pin
-#define NEO_init()  PIN_output(PIN_NEO)
+// Turn off all pixels without changing the buffer
+void NEO_off(void) {
+  INT_ATOMIC_BLOCK {
+    for(uint8_t i=0; i<NEO_COUNT*3; i++) NEO_sendByte(0);
+  }
+  NEO_black = 1;
+}
+
+// Init NeoPixel pin and buffer settings
+void NEO_init(void) {
+  PIN_output(PIN_NEO);
+  NEO_start = 0;
+  NEO_dim   = 0;
+  NEO_derate = 0;
+  NEO_black = 0;                  // pixel state unknown after power-up
+  for(uint8_t i=0; i<NEO_COUNT; i++) {
+    NEO_hue[i]    = 0;            // RAM is not cleared on start-up,
+    NEO_bright[i] = 0;            // hue values >191 would send no bytes
+  }
+}
 
 // ===================================================================================
 // NeoPixel Animation Functions
 // ===================================================================================
 
+// Get buffer index of a pixel number (applies rotation offset)
+uint8_t NEO_index(uint8_t number) {
+  number += NEO_start;
+  return((number >= NEO_COUNT) ? (number - NEO_COUNT) : number);
+}
+
 // Set color to a single pixel
 void NEO_set(uint8_t number, uint8_t hue) {
+  number = NEO_index(number);
   NEO_bright[number] = 6;
   NEO_hue[number] = hue;
 }
 
+// Add brightness to a single pixel (saturating), take over hue if brighter
+void NEO_add(uint8_t number, uint8_t hue, uint8_t bright) {
+  number = NEO_index(number);
+  if(bright > NEO_bright[number]) NEO_hue[number] = hue;
+  bright += NEO_bright[number];
+  NEO_bright[number] = (bright > 6) ? 6 : bright;
+}
+
 // Clear all pixels
 void NEO_clear(void) {
   for(uint8_t i=0; i<NEO_COUNT; i++) NEO_bright[i] = 0;
@@ -154,28 +229,99 @@ void NEO_fadeOut(void) {
   }
 }
 
-// Circle all pixels clockwise
+// Circle all pixels clockwise (only moves the rotation offset)
 void NEO_cw(void) {
-  uint8_t btemp = NEO_bright[NEO_COUNT-1];
-  uint8_t htemp = NEO_hue[NEO_COUNT-1];
-  for(uint8_t i=NEO_COUNT-1; i; i--) {
-    NEO_bright[i] = NEO_bright[i-1];
-    NEO_hue[i]    = NEO_hue[i-1];
-  }
-  NEO_bright[0] = btemp;
-  NEO_hue[0] = htemp;
+  NEO_start = (NEO_start ? NEO_start : NEO_COUNT) - 1;
 }
 
-// Circle all pixels counter-clockwise
+// Circle all pixels counter-clockwise (only moves the rotation offset)
 void NEO_ccw(void) {
-  uint8_t btemp = NEO_bright[0];
-  uint8_t htemp = NEO_hue[0];
-  for(uint8_t i=0; i<NEO_COUNT-1; i++) {
-    NEO_bright[i] = NEO_bright[i+1];
-    NEO_hue[i] = NEO_hue[i+1];
+  if(++NEO_start >= NEO_COUNT) NEO_start = 0;
+}
+
+// ===================================================================================
+// Particle System
+// ===================================================================================
+//
+// Particles live in a fixed pool in SRAM. Unused particles are chained in a free
+// list, active particles in an active list, so that spawning and expiring is O(1)
+// without any heap. Position and velocity are Q8.8 fixed-point values in pixels
+// (per frame), the particle fades out by its decay value each frame.
+// With ANIM_PROFILE the longest PART_update() is kept in partcost (CPU cycles at
+// 8MHz) for debugger read-out. Not yet measured on hardware, the estimate from the
+// code is ~25 cycles per particle for update and ~20 for render.
+
+#define PART_NONE       0xFF                    // end of list marker
+#define PART_RING       ((uint16_t)NEO_COUNT << 8)  // ring length in Q8.8
+
+// Particle structure
+typedef struct {
+  uint16_t pos;                                 // position in pixels (Q8.8)
+  int16_t  vel;                                 // velocity in pixels/frame (Q8.8)
+  uint8_t  hue;                                 // color hue (0..191)
+  uint8_t  life;                                // remaining life/brightness (0..255)
+  uint8_t  decay;                               // life decrease per frame
+  uint8_t  next;                                // index of next particle in list
+} PART_t;
+
+// Particle pool and list heads
+PART_t  PART_pool[PART_COUNT];
+uint8_t PART_free;                              // first free particle
+uint8_t PART_active;                            // first active particle
+
+// Init particle pool (all particles free)
+void PART_init(void) {
+  for(uint8_t i=0; i<PART_COUNT; i++) PART_pool[i].next = i + 1;
+  PART_pool[PART_COUNT-1].next = PART_NONE;
+  PART_free   = 0;
+  PART_active = PART_NONE;
+}
+
+// Spawn a new particle, returns 0 if pool is exhausted
+uint8_t PART_spawn(uint8_t pixel, int16_t vel, uint8_t hue, uint8_t decay) {
+  uint8_t nr = PART_free;
+  if(nr == PART_NONE) return 0;
+  PART_t *p   = &PART_pool[nr];
+  PART_free   = p->next;
+  p->pos      = (uint16_t)pixel << 8;
+  p->vel      = vel;
+  p->hue      = hue;
+  p->life     = 255;
+  p->decay    = decay;
+  p->next     = PART_active;
+  PART_active = nr;
+  return 1;
+}
+
+// Move and age all active particles, return expired ones to the free list
+void PART_update(void) {
+  uint8_t prev = PART_NONE;
+  uint8_t nr   = PART_active;
+  while(nr != PART_NONE) {
+    PART_t *p  = &PART_pool[nr];
+    uint8_t nx = p->next;
+    if(p->life <= p->decay) {                   // expired?
+      if(prev == PART_NONE) PART_active = nx;   // unlink from active list
+      else PART_pool[prev].next = nx;
+      p->next   = PART_free;                    // push onto free list
+      PART_free = nr;
+    }
+    else {
+      p->life -= p->decay;
+      p->pos  += p->vel;                        // move and wrap around the ring
+      if(p->pos >= PART_RING) p->pos += (p->vel < 0) ? PART_RING : -PART_RING;
+      prev = nr;
+    }
+    nr = nx;
+  }
+}
+
+// Render all active particles additively into the pixel buffer
+void PART_render(void) {
+  for(uint8_t nr=PART_active; nr!=PART_NONE; nr=PART_pool[nr].next) {
+    PART_t *p = &PART_pool[nr];
+    NEO_add(p->pos >> 8, p->hue, (p->life >> 5) + 1);
   }
-  NEO_bright[NEO_COUNT-1] = btemp;
-  NEO_hue[NEO_COUNT-1] = htemp;
 }
 
 // ===================================================================================
@@ -187,81 +333,306 @@ uint32_t prng(uint32_t max) {
   return(rnval % max);
 }
 
+// ===================================================================================
+// Fire Simulation
+// ===================================================================================
+//
+// Cellular heat diffusion on the circular ring: every frame each cell cools down by
+// a random amount, heat spreads to the neighbours (1-2-1 kernel with wrap-around)
+// and random sparks ignite new heat. The heat is mapped to hue (red..yellow) and
+// brightness, so the gamma correction in NEO_show still applies.
+// With ANIM_PROFILE the longest FIRE_update() is kept in firecost (CPU cycles at
+// 48MHz) for debugger read-out. Not yet measured on hardware, the estimate from the
+// code is ~3500 cycles for 16 pixels (~75us at 48MHz) without NEO_show.
+
+uint8_t FIRE_heat[NEO_COUNT];                   // heat value of each cell
+
+// Calculate next fire frame and write it into the pixel buffer
+void FIRE_update(void) {
+  uint8_t i, cool, cur, prev, first;
+
+  // Cool down every cell a little
+  for(i=0; i<NEO_COUNT; i++) {
+    cool = prng(FIRE_COOLING);
+    FIRE_heat[i] = (FIRE_heat[i] > cool) ? (FIRE_heat[i] - cool) : 0;
+  }
+
+  // Diffuse heat to the neighbours (wrap-around on the ring)
+  first = FIRE_heat[0];
+  prev  = FIRE_heat[NEO_COUNT-1];
+  for(i=0; i<NEO_COUNT; i++) {
+    cur = FIRE_heat[i];
+    FIRE_heat[i] = ((uint16_t)prev + (cur << 1) + ((i < NEO_COUNT-1) ? FIRE_heat[i+1] : first)) >> 2;
+    prev = cur;
+  }
+
+  // Ignite new sparks
+  if(prng(256) < FIRE_SPARKING) {
+    i = prng(NEO_COUNT);
+    cur = FIRE_heat[i] + 160 + prng(96);
+    FIRE_heat[i] = (cur < FIRE_heat[i]) ? 255 : cur;
+  }
+
+  // Map heat to color
+  for(i=0; i<NEO_COUNT; i++) {
+    cur = FIRE_heat[i];
+    NEO_hue[i]    = cur >> 3;                   // red (cold) .. orange-yellow (hot)
+    NEO_bright[i] = (cur > 191) ? 6 : (cur >> 5);
+  }
+}
+
+// ===================================================================================
+// Battery Monitor
+// ===================================================================================
+
+// The ADC stays powered down between the rare VDD samples. A sample takes about
+// 4 x 130us at slow ADC speed, i.e. less than 1ms every BAT_INTERVAL. The brightness
+// derating only increases, since VDD recovers a little as soon as the LEDs draw
+// less current, which would otherwise make the brightness flicker.
+
+// Sample supply voltage in millivolts (average of 4 conversions)
+uint16_t BAT_read(void) {
+  uint16_t vdd = 0;
+  ADC_enable();                           // power up ADC
+  DLY_us(10);                             // wait to settle
+  for(uint8_t i=4; i; i--) vdd += ADC_read_VDD();
+  ADC_disable();                          // power down ADC
+  return(vdd >> 2);
+}
+
+// Turn off all pixels and put device into standby until the battery is replaced
+void BAT_shutdown(void) {
+  NEO_clear(); NEO_show();                // turn off all LEDs
+  INT_disable();                          // no more wake-up by interrupts
+  AWU_stop();                             // no more wake-up by AWU
+  PWR_save(PWR_KEEP(PIN_NEO));            // all other pins to analog input
+  while(1) STDBY_WFE_now();               // sleep forever
+}
+
+// Check battery voltage, derate brightness or shut down
+void BAT_check(void) {
+  uint16_t vdd = BAT_read();
+  if(vdd < BAT_CUTOFF) BAT_shutdown();
+  if((vdd < BAT_LOW2) && (NEO_derate < 2)) NEO_derate = 2;
+  else if((vdd < BAT_LOW1) && (NEO_derate < 1)) NEO_derate = 1;
+}
+
+// Init ADC for VDD measurement and check battery once
+void BAT_init(void) {
+  ADC_init();                             // init and calibrate ADC
+  ADC_slow();                             // slow sampling for accurate Vref
+  BAT_check();                            // do not start on an empty battery
+}
+
+// ===================================================================================
+// Animation Task
+// ===================================================================================
+
+// Auto-off timeout in wheel ticks
+#define OFF_TIME        TMR_MS((uint32_t)AUTO_OFF * 60000)
+
+// Task slots
+#define TASK_FRAME      0                 // animation frame task
+#define TASK_TIMER      1                 // timer wheel (battery, auto-off)
+#define TASK_KEYTIMER   2                 // button driver timer
+#define TASK_KEY        3                 // button event task
+#define TASK_OFF        4                 // auto-off (signaled by timer)
+
+// Global variables
+uint8_t state;                            // animation state variable
+uint8_t counter;                          // animation state duration
+uint8_t hue1, hue2, ptr1, ptr2;           // animation parameters
+uint8_t mode;                             // automatic/button mode
+uint8_t offtimer;                         // timer id of auto-off timeout
+uint8_t dark;                             // number of consecutive black frames
+uint8_t held;                             // 1: long press handled
+
+#if ANIM_PROFILE > 0
+uint32_t partcost;                        // longest PART_update in cycles (debugger)
+uint32_t firecost;                        // longest FIRE_update in cycles (debugger)
+
+// Run update function, keep its longest run in cycles (SysTick at 48MHz: 1 tick
+// = 8 cycles, otherwise 1 tick = 1 cycle)
+#define ANIM_measure(cost, func) { \
+  uint32_t t = STK->CNT; func; t = STK->CNT - t; \
+  if(CLK_isFast()) t <<= 3; \
+  if(t > cost) cost = t; }
+#else
+#define ANIM_measure(cost, func) func
+#endif
+
+// Turn off all pixels and go to standby until the button is pressed (task)
+void OFF_now(void) {
+  NEO_off();                              // blank LEDs, keep frame buffer
+  AWU_disable();                          // button is the only wake-up source
+  KEY_sleep(PWR_KEEP(PIN_NEO));           // standby until button pressed
+  NEO_show();                             // show last frame right away
+  KEY_ignore();                           // wake-up press is no command
+  TMR_in(offtimer, OFF_TIME);             // restart inactivity timeout
+}
+
+// Auto-off timeout expired (timer callback, standby must not block the wheel)
+void OFF_timeout(void) {
+  SCHED_signal(TASK_OFF);
+}
+
+// Save animation state, mode and global brightness to flash
+void SET_save(void) {
+  uint8_t data[2];
+  data[0] = state;
+  if((state == 1) || (state == 4) || (state == 6))
+    data[0]--;                            // save the state that sets up the buffer
+  data[1] = mode | (NEO_dim << 1);
+  STORE_write(data);
+}
+
+// Handle button events (signaled by button driver)
+void ANIM_key(void) {
+  uint8_t event;
+  while((event = KEY_get()) != KEY_NONE) {
+    #if AUTO_OFF > 0
+    TMR_in(offtimer, OFF_TIME);           // restart inactivity timeout
+    #endif
+    switch(event) {
+      case KEY_PRESS:   held = 0;
+                        break;
+
+      case KEY_LONG:    if(++NEO_dim > NEO_DIM_MAX) NEO_dim = 0;  // next brightness
+                        held = 1; SET_save();
+                        break;
+
+      case KEY_RELEASE: if(mode && !held) {                      // short press in
+                          if(++state > 10) state = 0;            // button mode:
+                          SET_save();                            // next animation
+                        }
+                        break;
+
+      default:          break;
+    }
+  }
+}
+
+// Calculate and show next animation frame, handle button (every NEO_REFRESH ms)
+void ANIM_frame(void) {
+  if(dark < NEO_DARK) SCHED_next(TASK_FRAME, SCHED_MS(NEO_REFRESH));
+  else                SCHED_next(TASK_FRAME, SCHED_MS(NEO_REFRESH * 2));
+
+  switch(state) {
+    case 0:   hue1 = 0; hue2 = 96; ptr1 = 0; ptr2 = NEO_COUNT>>1; state++;
+              break;
+              
+    case 1:   NEO_fadeOut(); hue1 += 4; hue2 += 4;
+              if(hue1 > 191) hue1 -= 192;
+              if(hue2 > 191) hue2 -= 192;
+              if(++ptr1 >= NEO_COUNT) ptr1 = 0;
+              if(++ptr2 >= NEO_COUNT) ptr2 = 0;
+              NEO_set(ptr1, hue1); NEO_set(ptr2, hue2); NEO_show();
+              break;
+           
+    case 2:   NEO_fadeOut();
+              for(uint8_t i=prng(4); i; i--) NEO_set(prng(NEO_COUNT), prng(192));
+              NEO_show();
+              break;
+
+    case 3:   for(uint8_t i=0; i<NEO_COUNT; i++) NEO_set(i, prng(192));
+              state++; NEO_show();
+              break;
+
+    case 4:   for(uint8_t i=0; i<NEO_COUNT; i++) {
+                NEO_hue[i] += prng(8); 
+                if(NEO_hue[i] > 191) NEO_hue[i] -= 192;
+              }
+              NEO_show();
+              break;
+              
+    case 5:   hue1 = 0;
+              for(uint8_t i=0; i<NEO_COUNT; i++, hue1+=192/NEO_COUNT) NEO_set(i, hue1);
+              state++; NEO_show();
+              break;
+              
+    case 6:   NEO_cw(); NEO_show();
+              break;
+
+    case 7:   hue1 += 3; if(hue1 > 191) hue1 -= 192;
+              NEO_fill(hue1); NEO_show();
+              break;
+
+    case 8:   hue1 += 1; if(hue1 > 191) hue1 -= 192;
+              ptr1 += 8; ptr2 = ptr1;
+              for(uint8_t i=0; i<NEO_COUNT; i++, ptr2+=256/NEO_COUNT) {
+                NEO_hue[i]    = hue1;
+                NEO_bright[i] = ((uint16_t)sin8(ptr2) * 7) >> 8;
+              }
+              NEO_show();
+              break;
+
+    case 9:   NEO_fadeOut(); NEO_fadeOut();
+              if(!prng(6)) PART_spawn(prng(NEO_COUNT), prng(2) ? 0x60 : -0x60, prng(192), 3);
+              if(!prng(3)) PART_spawn(prng(NEO_COUNT), 0, prng(192), 48);
+              ANIM_measure(partcost, PART_update());
+              PART_render(); NEO_show();
+              break;
+
+    case 10:  CLK_fast();                 // compute fire at 48MHz
+              ANIM_measure(firecost, FIRE_update());
+              CLK_slow();                 // transmit at 8MHz (timing is fixed)
+              NEO_show();
+              break;
+              
+    default:  break;
+  }
+
+  if(!mode) {                       // atomatic animation switching
+    if(!(--counter)) {
+      counter = NEO_AUTO_COUNT;
+      state++;
+    }
+  }
+  if(state > 10) state = 0;
+  if(!NEO_black) dark = 0;          // count black frames for longer period
+  else if(dark < NEO_DARK) dark++;
+}
+
 // ===================================================================================
 // Main Function
 // ===================================================================================
 int main(void) {
   // Local variables
-  uint8_t state = 0;                    // animation state variable
-  uint8_t counter = NEO_AUTO_COUNT;     // animation state duration
-  uint8_t hue1, hue2, ptr1, ptr2;       // animation parameters
-  uint8_t mode;                         // automatic/button mode
+  uint8_t set[2];                       // stored settings
 
   // Setup
-  PIN_input_PU(PIN_KEY);                // set button pin to input pullup
   NEO_init();                           // init NeoPixels
-  AWU_start(NEO_REFRESH);               // start automatic wake-up timer
-  mode = !PIN_read(PIN_KEY);            // read button on start-up and set mode
+  BAT_init();                           // check battery before anything else
+  PART_init();                          // init particle pool
+  state   = 0;                          // default settings
+  mode    = 0;
+  counter = NEO_AUTO_COUNT;
+  dark    = 0;
+  if(STORE_read(set)) {                 // restore last settings
+    state   = set[0];
+    mode    = set[1] & 1;
+    NEO_dim = (set[1] >> 1) & 3;
+  }
+  SCHED_init();                         // init scheduler
+  KEY_init(TASK_KEYTIMER, TASK_KEY);    // init button driver
+  SCHED_set(TASK_KEY, ANIM_key);        // attach button event task
+  if(KEY_isPressed()) {                 // button held on start-up?
+    mode = !mode;                       // toggle and store automatic/button mode
+    SET_save();
+    KEY_ignore();                       // ignore until button released
+  }
+  LAT_init();                           // init latency statistics
+  SCHED_keep(PWR_KEEP(PIN_NEO) | PWR_KEEP(PIN_KEY));  // other pins unused
+  SCHED_set(TASK_FRAME, ANIM_frame);    // attach animation task
+  SCHED_in(TASK_FRAME, 0);              // start animation
+  TMR_init(TASK_TIMER);                 // init timer wheel
+  TMR_every(TMR_new(BAT_check), TMR_MS(BAT_INTERVAL));  // battery monitor
+  #if AUTO_OFF > 0
+  SCHED_set(TASK_OFF, OFF_now);         // auto-off after inactivity
+  offtimer = TMR_new(OFF_timeout);
+  TMR_in(offtimer, OFF_TIME);
+  #endif
 
   // Loop
-  while(1) {
-    // Animate
-    switch(state) {
-      case 0:   hue1 = 0; hue2 = 96; ptr1 = 0; ptr2 = NEO_COUNT>>1; state++;
-                break;
-                
-      case 1:   NEO_fadeOut(); hue1 += 4; hue2 += 4;
-                if(hue1 > 191) hue1 -= 192;
-                if(hue2 > 191) hue2 -= 192;
-                if(++ptr1 >= NEO_COUNT) ptr1 = 0;
-                if(++ptr2 >= NEO_COUNT) ptr2 = 0;
-                NEO_set(ptr1, hue1); NEO_set(ptr2, hue2); NEO_show();
-                break;
-             
-      case 2:   NEO_fadeOut();
-                for(uint8_t i=prng(4); i; i--) NEO_set(prng(NEO_COUNT), prng(192));
-                NEO_show();
-                break;
-
-      case 3:   for(uint8_t i=0; i<NEO_COUNT; i++) NEO_set(i, prng(192));
-                state++; NEO_show();
-                break;
-
-      case 4:   for(uint8_t i=0; i<NEO_COUNT; i++) {
-                  NEO_hue[i] += prng(8); 
-                  if(NEO_hue[i] > 191) NEO_hue[i] -= 192;
-                }
-                NEO_show();
-                break;
-                
-      case 5:   hue1 = 0;
-                for(uint8_t i=0; i<NEO_COUNT; i++, hue1+=192/NEO_COUNT) NEO_set(i, hue1);
-                state++; NEO_show();
-                break;
-                
-      case 6:   NEO_cw(); NEO_show();
-                break;
-
-      case 7:   hue1 += 3; if(hue1 > 191) hue1 -= 192;
-                NEO_fill(hue1); NEO_show();
-                break;
-                
-      default:  break;
-    }
-
-    if(mode) {                      // animation switching on button press
-      if(!PIN_read(PIN_KEY)) {
-        state++;
-        while(!PIN_read(PIN_KEY));
-      }
-    }
-    else {                          // atomatic animation switching
-      if(!(--counter)) {
-        counter = NEO_AUTO_COUNT;
-        state++;
-      }
-    }
-    if(state > 7) state = 0;
-    STDBY_WFE_now();                // go to standby, wake up by AWU after defined period
-  }
+  while(1) SCHED_run();                 // run tasks, sleep in between
 }
@@ -0,0 +1,97 @@
+// ===================================================================================
+// Wear-Leveled Record Store in Flash for CH32V003                            * v1.0 *
+// ===================================================================================
+//
+// Record layout (one 32-bit slot, written as two half-words):
+// byte 0: sequence number, byte 1-2: data, byte 3: check byte
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#include "store.h"
+
+// Newest record slot and sequence number (set by STORE_read)
+static uint8_t STORE_slot = STORE_SLOTS - 1;
+static uint8_t STORE_seq  = 0;
+
+// ===================================================================================
+// Flash Low-Level Functions
+// ===================================================================================
+
+// Unlock flash and fast programming mode
+static void STORE_unlock(void) {
+  FLASH->KEYR     = FLASH_KEY1;
+  FLASH->KEYR     = FLASH_KEY2;
+  FLASH->MODEKEYR = FLASH_KEY1;
+  FLASH->MODEKEYR = FLASH_KEY2;
+}
+
+// Lock flash and fast programming mode
+static void STORE_lock(void) {
+  FLASH->CTLR = FLASH_CTLR_LOCK | FLASH_CTLR_FLOCK;
+}
+
+// Erase one 64-byte page
+static void STORE_erasePage(uint32_t addr) {
+  FLASH->CTLR  = FLASH_CTLR_PAGE_ER;            // fast page erase
+  FLASH->ADDR  = addr;                          // set page address
+  FLASH->CTLR  = FLASH_CTLR_PAGE_ER | FLASH_CTLR_STRT;
+  while(FLASH->STATR & FLASH_STATR_BSY);        // wait until finished
+  FLASH->CTLR  = 0;
+}
+
+// Program one half-word
+static void STORE_writeHalf(uint32_t addr, uint16_t data) {
+  FLASH->CTLR  = FLASH_CTLR_PG;                 // standard programming
+  *(__IO uint16_t*)(uintptr_t)addr = data;      // write half-word
+  while(FLASH->STATR & FLASH_STATR_BSY);        // wait until finished
+  FLASH->CTLR  = 0;
+}
+
+// Calculate check byte of a record
+static uint8_t STORE_check(uint32_t rec) {
+  return(STORE_MAGIC ^ rec ^ (rec >> 8) ^ (rec >> 16));
+}
+
+// Check if a slot is erased (never a valid record, the check byte does not match)
+static uint8_t STORE_isBlank(uint32_t rec) {
+  return((rec == 0xFFFFFFFF) || (rec == STORE_BLANK));
+}
+
+// ===================================================================================
+// Store Functions
+// ===================================================================================
+
+// Find newest valid record, copy its data and return 1 (0 if no record found)
+uint8_t STORE_read(uint8_t *data) {
+  uint8_t found = 0;
+  const uint32_t *slot = (const uint32_t*)STORE_START;
+  for(uint8_t i=0; i<STORE_SLOTS; i++) {
+    uint32_t rec = slot[i];
+    if((uint8_t)(rec >> 24) != STORE_check(rec)) continue;
+    if(!found || ((int8_t)((uint8_t)rec - STORE_seq) > 0)) {
+      STORE_slot = i;
+      STORE_seq  = rec;
+      data[0]    = rec >> 8;
+      data[1]    = rec >> 16;
+      found      = 1;
+    }
+  }
+  return found;
+}
+
+// Append a new record to the next blank slot (skips slots torn by a power loss)
+void STORE_write(const uint8_t *data) {
+  uint32_t rec, addr;
+  do {
+    if(++STORE_slot >= STORE_SLOTS) STORE_slot = 0;
+    addr = STORE_START + ((uint32_t)STORE_slot << 2);
+  } while((addr & (STORE_PAGE_SIZE - 1))
+       && !STORE_isBlank(*(const uint32_t*)(uintptr_t)addr));
+  rec  = (uint8_t)(++STORE_seq) | ((uint32_t)data[0] << 8) | ((uint32_t)data[1] << 16);
+  rec |= (uint32_t)STORE_check(rec) << 24;
+  STORE_unlock();
+  if(!(addr & (STORE_PAGE_SIZE - 1))) STORE_erasePage(addr);  // entering new page?
+  STORE_writeHalf(addr,     rec);
+  STORE_writeHalf(addr + 2, rec >> 16);
+  STORE_lock();
+}
@@ -0,0 +1,54 @@
+// ===================================================================================
+// Wear-Leveled Record Store in Flash for CH32V003                            * v1.0 *
+// ===================================================================================
+//
+// Stores small settings records (two data bytes) in the last flash pages. Each
+// record is appended to the next free slot together with a sequence number and a
+// check byte, so every slot is written only once per erase cycle. A page is erased
+// just before the first slot in it is written. With the default two 64-byte pages
+// (32 slots), each page is erased only once every 32 writes.
+//
+// Functions available:
+// --------------------
+// STORE_read(data)         find newest record, copy its 2 data bytes, return 0 if none
+// STORE_write(data)        append a new record with 2 data bytes
+//
+// Notes:
+// ------
+// - STORE_read() must be called once at startup before STORE_write() is used.
+// - STORE_read() scans all slots. That takes about 400 cycles (~50us at 8MHz).
+// - The store area must be excluded from the FLASH region in the linker script.
+// - A write torn by a power loss leaves an invalid slot. STORE_read() ignores it and
+//   STORE_write() skips it, as a slot can only be programmed once after an erase.
+//   Erased flash reads as STORE_BLANK on the CH32V003 (0xFFFFFFFF on other parts).
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "system.h"
+
+// ===================================================================================
+// Store Settings
+// ===================================================================================
+#define STORE_PAGES       2                           // number of 64-byte flash pages
+#define STORE_PAGE_SIZE   64                          // flash page size in bytes
+#define STORE_SIZE        (STORE_PAGES * STORE_PAGE_SIZE)
+#define STORE_START       (FLASH_BASE + 0x4000 - STORE_SIZE)  // at the end of flash
+#define STORE_SLOTS       (STORE_SIZE / 4)            // 4 bytes per record
+#define STORE_MAGIC       0xA5                        // check byte seed
+#define STORE_BLANK       0xE339E339                  // erased slot read on CH32V003
+
+// ===================================================================================
+// Store Functions
+// ===================================================================================
+uint8_t STORE_read(uint8_t *data);                    // read newest record
+void    STORE_write(const uint8_t *data);             // append new record
+
+#ifdef __cplusplus
+};
+#endif
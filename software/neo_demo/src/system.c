@@ -22,12 +22,10 @@ void SYS_init(void) {
   #if F_CPU > 24000000
   FLASH->ACTLR = FLASH_ACTLR_LATENCY_1;                     // 1 cycle latency
   #endif
-  CLK_init();                                               // init system clock
+  #if (SYS_USE_HSE == 0) && !defined(SYS_USE_PLL)
+  if(RCC->CFGR0 != CLK_DIV)                                 // not yet at F_CPU?
   #endif
-
-  // Init SYSTICK
-  #if SYS_TICK_INIT > 0
-  STK_init();
+  CLK_init();                                               // init system clock
   #endif
 
   // Enable GPIO
@@ -87,6 +85,40 @@ void CLK_reset(void) {
   FLASH->ACTLR = FLASH_ACTLR_LATENCY_0;                         // no flash wait states
 }
 
+#if SYS_CLK_SWITCH > 0
+// SysTick counter value when switching to 48MHz
+static uint32_t CLK_fastStart;
+
+// Switch system clock from 8MHz (HSI/3) to 48MHz (HSI with PLL) at runtime
+void CLK_fast(void) {
+  if(CLK_isFast()) return;
+  FLASH->ACTLR = FLASH_ACTLR_LATENCY_1;                         // 1 cycle latency
+  RCC->CTLR   |= RCC_PLLON;                                     // enable PLL
+  while(!(RCC->CTLR & RCC_PLLRDY));                             // wait till PLL is ready
+  INT_ATOMIC_BLOCK {
+    RCC->CFGR0  = RCC_HPRE_DIV1 | RCC_SW_PLL;                   // select PLL, no divider
+    while((RCC->CFGR0 & RCC_SWS) != RCC_SWS_PLL);               // wait till PLL is used
+    STK->CTLR  &= ~STK_CTLR_STCLK;                              // SysTick @ HCLK/8 = 6MHz
+    CLK_fastStart = STK->CNT;
+  }
+}
+
+// Switch system clock back to 8MHz (HSI/3) and correct the SysTick counter
+void CLK_slow(void) {
+  uint32_t lost;
+  if(!CLK_isFast()) return;
+  INT_ATOMIC_BLOCK {
+    RCC->CFGR0  = CLK_DIV;                                      // select HSI/3
+    while(RCC->CFGR0 & RCC_SWS);                                // wait till HSI is used
+    STK->CTLR  |= STK_CTLR_STCLK;                               // SysTick @ HCLK = 8MHz
+    lost        = (STK->CNT - CLK_fastStart) / 3;               // 2 of 8 ticks missing
+    STK->CNT   += lost;                                         // add them
+  }
+  RCC->CTLR   &= ~RCC_PLLON;                                    // disable PLL
+  FLASH->ACTLR = FLASH_ACTLR_LATENCY_0;                         // no flash wait states
+}
+#endif
+
 // Setup pin PC4 for MCO (output, push-pull, 50MHz, auxiliary)
 void MCO_init(void) {
   RCC->APB2PCENR |= RCC_AFIOEN | RCC_IOPCEN;
@@ -99,10 +131,86 @@ void MCO_init(void) {
 
 // Wait n counts of SysTick
 void DLY_ticks(uint32_t n) {
+  #if SYS_CLK_SWITCH > 0
+  if(CLK_isFast()) n -= n >> 2;                                 // SysTick @ 6MHz
+  #endif
   uint32_t end = STK->CNT + n;
   while(((int32_t)(STK->CNT - end)) < 0);
 }
 
+#if SYS_USE_VECTORS > 0
+// ===================================================================================
+// Alarm Functions (SysTick Compare)
+// ===================================================================================
+static ALM_func_t       ALM_func;               // handler called in interrupt
+static uint32_t         ALM_period;             // 0: one-shot, else period in ticks
+static volatile uint8_t ALM_flag;               // 1: alarm has fired
+volatile ALM_lat_t      ALM_lat;                // interrupt entry latency
+
+// SysTick compare interrupt
+void SysTick_Handler(void) __attribute__((interrupt));
+void SysTick_Handler(void) {
+  #if SYS_IRQ_LATENCY > 0
+  uint32_t lat = STK->CNT - STK->CMP;           // ticks since compare match
+  ALM_lat.last = lat;
+  if(lat > ALM_lat.max) ALM_lat.max = lat;
+  #endif
+  STK->SR = 0;                                  // clear compare flag
+  if(ALM_period) STK->CMP += ALM_period;        // periodic: set next compare value
+  else STK->CTLR &= ~STK_CTLR_STIE;             // one-shot: disable interrupt
+  ALM_flag = 1;
+  if(ALM_func) ALM_func();
+}
+
+// Enable SysTick interrupt (bind to VTF slot if enabled)
+void ALM_init(void) {
+  STK->SR = 0;
+  #if SYS_USE_VTF > 0
+  INT_VTF_bind(VTF_SLOT_ALARM, SysTicK_IRQn, SysTick_Handler);
+  #endif
+  #if SYS_IRQ_LATENCY > 0
+  ALM_lat.last = 0;
+  ALM_lat.max  = 0;
+  #endif
+  NVIC_EnableIRQ(SysTicK_IRQn);
+}
+
+// Fire alarm at SysTick time, then every period ticks (0: once)
+void ALM_start(uint32_t time, uint32_t period, ALM_func_t func) {
+  INT_ATOMIC_BLOCK {                            // handler must not run in between
+    STK->CTLR &= ~STK_CTLR_STIE;                // stop running alarm
+    NVIC_ClearPendingIRQ(SysTicK_IRQn);         // drop its pending interrupt
+    ALM_func   = func;
+    ALM_period = period;
+    ALM_flag   = 0;
+    STK->CMP   = time;                          // set compare value
+    STK->SR    = 0;                             // clear compare flag
+    STK->CTLR |= STK_CTLR_STIE;                 // enable compare interrupt
+    if((((int32_t)(STK->CNT - time)) >= 0) && !(STK->SR & STK_SR_CNTIF))
+      NVIC_SetPendingIRQ(SysTicK_IRQn);         // missed without a match: pend once
+  }
+}
+
+// Check if alarm has fired since last start
+uint8_t ALM_fired(void) {
+  return ALM_flag;
+}
+
+// Sleep until SysTick time or any interrupt (call with interrupts disabled)
+void ALM_sleep(uint32_t time) {
+  ALM_start(time, 0, 0);                        // one-shot, wake-up only
+  if(((int32_t)(STK->CNT - time)) < 0) SLEEP_WFI_now(); // still in the future? sleep
+  ALM_stop();                                   // woken by other interrupt?
+}
+
+// Sleep until SysTick time, other interrupts are served meanwhile (if enabled)
+void ALM_wait(uint32_t time) {
+  while(((int32_t)(STK->CNT - time)) < 0) {
+    INT_ATOMIC_BLOCK { ALM_sleep(time); }       // restores the caller's MIE
+  }
+}
+#endif
+
 // ===================================================================================
 // Bootloader (BOOT) Functions
 // ===================================================================================
@@ -199,6 +307,54 @@ void STDBY_WFE_now(void) {
   PWR->CTLR   &= ~PWR_CTLR_PDDS;        // disable PDDS again
 }
 
+// ===================================================================================
+// Power Saving Functions
+// ===================================================================================
+
+// Saved configuration
+static uint32_t PWR_cfg[3];                     // GPIO port configurations
+static uint32_t PWR_apb1, PWR_apb2;             // peripheral clock enables
+static uint32_t PWR_adc;                        // ADC power state
+
+// Set all pins except the kept ones to analog input and gate unused clocks
+void PWR_save(uint32_t keep) {
+  static GPIO_TypeDef* const port[3] = {GPIOA, GPIOC, GPIOD};
+  static const uint8_t portclk[3] = {RCC_IOPAEN, RCC_IOPCEN, RCC_IOPDEN};
+  uint32_t cfg, mask, clk = RCC_AFIOEN;
+  keep |= PWR_KEEP(17);                         // keep SWIO (PD1) for debugging
+  PWR_apb1 = RCC->APB1PCENR;
+  PWR_apb2 = RCC->APB2PCENR;
+  RCC->APB2PCENR = PWR_apb2 | RCC_IOPAEN | RCC_IOPCEN | RCC_IOPDEN;
+  for(uint8_t i=0; i<3; i++, keep>>=8) {
+    cfg = port[i]->CFGLR;
+    PWR_cfg[i] = cfg;
+    mask = 0;
+    for(uint8_t pin=0; pin<8; pin++) {          // nibble mask of kept pins
+      if(keep & (1 << pin)) mask |= (uint32_t)0b1111 << (pin << 2);
+    }
+    port[i]->CFGLR = cfg & mask;                // others to analog input (0b0000)
+    if(keep & 0xFF) clk |= portclk[i];          // keep clock of used port
+  }
+  PWR_adc = 0;
+  if(PWR_apb2 & RCC_ADC1EN) {                   // ADC clocked?
+    PWR_adc = ADC1->CTLR2 & ADC_ADON;
+    ADC1->CTLR2 &= ~ADC_ADON;                   // power down ADC
+  }
+  RCC->APB2PCENR = clk;                         // gate unused APB2 clocks
+  RCC->APB1PCENR = RCC_PWREN;                   // only power module on APB1
+}
+
+// Restore pins and clocks after wake-up
+void PWR_restore(void) {
+  RCC->APB2PCENR = PWR_apb2 | RCC_IOPAEN | RCC_IOPCEN | RCC_IOPDEN;
+  RCC->APB1PCENR = PWR_apb1;
+  GPIOA->CFGLR   = PWR_cfg[0];
+  GPIOC->CFGLR   = PWR_cfg[1];
+  GPIOD->CFGLR   = PWR_cfg[2];
+  if(PWR_adc) ADC1->CTLR2 |= ADC_ADON;          // power up ADC again
+  RCC->APB2PCENR = PWR_apb2;
+}
+
 // ===================================================================================
 // C++ Support
 // Based on CNLohr ch32v003fun: https://github.com/cnlohr/ch32v003fun
@@ -229,6 +385,9 @@ extern uint32_t _data_lma;
 extern uint32_t _data_vma;
 extern uint32_t _edata;
 
+// Boot times
+volatile SYS_boot_t SYS_boot;
+
 // Prototypes
 int main(void)                __attribute__((section(".text.main"), used));
 void jump_reset(void)         __attribute__((section(".init.jump"), naked, used));
@@ -246,7 +405,7 @@ void default_handler(void)    { while(1); }
 #define DUMMY_HANDLER __attribute__((section(".text.vector_handler"), weak, alias("default_handler"), used))
 DUMMY_HANDLER void NMI_Handler(void);
 DUMMY_HANDLER void HardFault_Handler(void);
-DUMMY_HANDLER void SysTick_Handler(void);
+void SysTick_Handler(void)    __attribute__((interrupt));  // alarm functions
 DUMMY_HANDLER void SW_Handler(void);
 DUMMY_HANDLER void WWDG_IRQHandler(void);
 DUMMY_HANDLER void PVD_IRQHandler(void);
@@ -344,17 +503,36 @@ void reset_handler(void) {
     : : [main] "r" (main) : "a0", "a1" , "memory"
   );
 
-  // Copy data from FLASH to RAM
+  // Start SYSTICK, SysTick times count from here
+  #if SYS_TICK_INIT > 0
+  STK_init();
+  #endif
+
+  // Copy data from FLASH to RAM (word-aligned by linker script, 4 words per pass)
   src = &_data_lma;
   dst = &_data_vma;
+  while(dst + 4 <= &_edata) {
+    dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3];
+    dst += 4; src += 4;
+  }
   while(dst < &_edata) *dst++ = *src++;
 
   // Clear uninitialized variables
   #if SYS_CLEAR_BSS > 0
   dst = &_sbss;
+  while(dst + 4 <= &_ebss) {
+    dst[0] = 0; dst[1] = 0; dst[2] = 0; dst[3] = 0;
+    dst += 4;
+  }
   while(dst < &_ebss) *dst++ = 0;
   #endif
 
+  // Record boot time
+  #if SYS_BOOT_TIME > 0
+  SYS_boot.init  = STK->CNT;
+  SYS_boot.frame = 0;
+  #endif
+
   // C++ Support
   #ifdef __cplusplus
   __libc_init_array();
@@ -363,6 +541,11 @@ void reset_handler(void) {
   // Init system
   SYS_init();
 
+  // Record boot time
+  #if SYS_BOOT_TIME > 0
+  SYS_boot.main  = STK->CNT;
+  #endif
+
   // Return
   asm volatile("mret");
 }
@@ -0,0 +1,182 @@
+// ===================================================================================
+// Software Timer Wheel for CH32V003                                          * v1.0 *
+// ===================================================================================
+//
+// Each bucket is a doubly linked list of pool indices. A timer that is due in d
+// wheel ticks is put into the bucket d steps ahead of the cursor and skips
+// (d - 1) / TMR_SLOTS visits of the cursor before it expires.
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#include "tmr.h"
+
+#define TMR_MASK          (TMR_SLOTS - 1)
+#define TMR_IDLE          0xFF                          // timer not running
+#define TMR_FIRE          0xFE                          // timer expired, callback due
+
+// Timer pool
+typedef struct {
+  TMR_func_t func;                                      // callback (NULL: free)
+  uint32_t   period;                                    // 0: once, else ticks
+  uint16_t   rounds;                                    // visits left until expiry
+  uint8_t    slot;                                      // bucket, TMR_IDLE, TMR_FIRE
+  uint8_t    next, prev;                                // bucket list
+} TMR_timer_t;
+
+static TMR_timer_t TMR_pool[TMR_POOL];
+static uint8_t     TMR_head[TMR_SLOTS];                 // first timer of each bucket
+static uint8_t     TMR_task;                            // scheduler slot of wheel
+static uint8_t     TMR_cursor;                          // current bucket
+static uint8_t     TMR_count;                           // number of running timers
+static uint8_t     TMR_busy;                            // 1: wheel step running
+static uint32_t    TMR_time;                            // SysTick time of cursor
+static uint32_t    TMR_wake;                            // SysTick time of next step
+volatile TMR_stat_t TMR_stat;
+
+// ===================================================================================
+// Bucket Functions
+// ===================================================================================
+
+// Remove timer from its bucket
+static void TMR_unlink(uint8_t id) {
+  TMR_timer_t *t = &TMR_pool[id];
+  if(t->slot < TMR_SLOTS) {
+    if(t->prev != TMR_NONE) TMR_pool[t->prev].next = t->next;
+    else TMR_head[t->slot] = t->next;
+    if(t->next != TMR_NONE) TMR_pool[t->next].prev = t->prev;
+    TMR_count--;
+  }
+  t->slot = TMR_IDLE;
+}
+
+// Put timer into the bucket d wheel ticks ahead of the cursor (d >= 1)
+static void TMR_link(uint8_t id, uint32_t d) {
+  TMR_timer_t *t = &TMR_pool[id];
+  uint8_t slot   = (TMR_cursor + d) & TMR_MASK;
+  t->rounds = (d - 1) >> TMR_SLOT_BITS;
+  t->slot   = slot;
+  t->prev   = TMR_NONE;
+  t->next   = TMR_head[slot];
+  if(t->next != TMR_NONE) TMR_pool[t->next].prev = id;
+  TMR_head[slot] = id;
+  TMR_count++;
+}
+
+// ===================================================================================
+// Wheel Step (Scheduler Task)
+// ===================================================================================
+
+// Schedule wheel task for the next non-empty bucket, stop it if there is none
+static void TMR_schedule(void) {
+  uint8_t d;
+  if(!TMR_count) {
+    SCHED_stop(TMR_task);
+    return;
+  }
+  for(d=1; (d < TMR_SLOTS) && (TMR_head[(TMR_cursor + d) & TMR_MASK] == TMR_NONE); d++);
+  TMR_wake = TMR_time + ((uint32_t)d << TMR_SHIFT);
+  SCHED_at(TMR_task, TMR_wake);
+}
+
+// Advance cursor to the scheduled bucket and run expired timers
+static void TMR_step(void) {
+  uint8_t  fire[TMR_POOL];
+  uint8_t  i, id, next, n = 0;
+  uint32_t start = STK->CNT, calls = 0;
+  TMR_busy = 1;
+
+  // Advance cursor, collect expired timers of the bucket
+  TMR_cursor = (TMR_cursor + ((TMR_wake - TMR_time) >> TMR_SHIFT)) & TMR_MASK;
+  TMR_time   = TMR_wake;
+  for(id = TMR_head[TMR_cursor]; id != TMR_NONE; id = next) {
+    next = TMR_pool[id].next;
+    if(TMR_pool[id].rounds) TMR_pool[id].rounds--;
+    else {
+      TMR_unlink(id);
+      TMR_pool[id].slot = TMR_FIRE;
+      fire[n++] = id;
+    }
+  }
+
+  // Restart periodic timers, run callbacks (unless stopped or restarted meanwhile)
+  for(i=0; i<n; i++) {
+    id = fire[i];
+    if(TMR_pool[id].slot != TMR_FIRE) continue;
+    if(TMR_pool[id].period) TMR_link(id, TMR_pool[id].period);
+    else TMR_pool[id].slot = TMR_IDLE;
+    calls -= STK->CNT;                                  // time spent in callbacks
+    TMR_pool[id].func();
+    calls += STK->CNT;
+  }
+  TMR_busy = 0;
+  TMR_schedule();
+
+  // Statistics (wheel bookkeeping only)
+  start = STK->CNT - start - calls;
+  if(start > TMR_stat.max) TMR_stat.max = start;
+  TMR_stat.steps++;
+}
+
+// ===================================================================================
+// Timer Functions
+// ===================================================================================
+
+// Start timer in ticks from now (rounded up to the next wheel step)
+static void TMR_start(uint8_t id, uint32_t ticks, uint32_t period) {
+  uint32_t d, visit;
+  TMR_unlink(id);
+  if(!TMR_count && !TMR_busy) TMR_time = STK->CNT;     // wheel was idle: restart
+  d = ticks + ((STK->CNT - TMR_time + TMR_TICK - 1) >> TMR_SHIFT);
+  if(!d) d = 1;
+  TMR_pool[id].period = period;
+  TMR_link(id, d);
+  if(TMR_busy) return;                                  // step schedules itself
+  visit = TMR_time + ((((d - 1) & TMR_MASK) + 1) << TMR_SHIFT);
+  if((TMR_count == 1) || ((int32_t)(visit - TMR_wake) < 0)) {
+    TMR_wake = visit;                                   // first visit of the new
+    SCHED_at(TMR_task, visit);                          // timer is the next step
+  }
+}
+
+// Run timer once in ticks
+void TMR_in(uint8_t id, uint32_t ticks) {
+  TMR_start(id, ticks, 0);
+}
+
+// Run timer every ticks
+void TMR_every(uint8_t id, uint32_t ticks) {
+  TMR_start(id, ticks, ticks ? ticks : 1);
+}
+
+// Stop timer
+void TMR_stop(uint8_t id) {
+  TMR_unlink(id);
+}
+
+// Get timer from pool
+uint8_t TMR_new(TMR_func_t func) {
+  for(uint8_t id=0; id<TMR_POOL; id++) {
+    if(!TMR_pool[id].func) {
+      TMR_pool[id].func = func;
+      TMR_pool[id].slot = TMR_IDLE;
+      return id;
+    }
+  }
+  return TMR_NONE;
+}
+
+// Init timer wheel
+void TMR_init(uint8_t task) {
+  uint8_t i;
+  for(i=0; i<TMR_POOL;  i++) TMR_pool[i].func = 0;
+  for(i=0; i<TMR_SLOTS; i++) TMR_head[i] = TMR_NONE;
+  TMR_task   = task;
+  TMR_cursor = 0;
+  TMR_count  = 0;
+  TMR_busy   = 0;
+  TMR_time   = STK->CNT;
+  TMR_wake   = TMR_time;
+  TMR_stat.max   = 0;
+  TMR_stat.steps = 0;
+  SCHED_set(task, TMR_step);
+}
@@ -0,0 +1,83 @@
+// ===================================================================================
+// Software Timer Wheel for CH32V003                                          * v1.0 *
+// ===================================================================================
+//
+// Runs many timeouts on a single scheduler task slot. Timers come from a static
+// pool and are hashed into TMR_SLOTS buckets by their expiry tick (hashed timing
+// wheel). Starting and stopping a timer is O(1). A wheel step only touches the
+// timers in one bucket, so its cost grows with timers / TMR_SLOTS (plus the work
+// for each expired timer) instead of with all running timers. The wheel is not
+// driven by a periodic tick: after each step the task is scheduled for the next
+// non-empty bucket and stopped if no timer is running, so an idle wheel does not
+// wake up the device. Timeouts longer than one wheel revolution are counted in
+// rounds.
+//
+// Functions available:
+// --------------------
+// TMR_init(task)           init wheel, task: scheduler slot used by the wheel
+// TMR_new(func)            get timer from pool with callback func (TMR_NONE if empty)
+// TMR_in(id, n)            run timer id once in n wheel ticks
+// TMR_every(id, n)         run timer id every n wheel ticks (first in n ticks)
+// TMR_stop(id)             stop timer id
+// TMR_MS(n)                convert n milliseconds to wheel ticks (for constant n)
+//
+// TMR_stat                 cost of the wheel steps for debug read-out
+//
+// Notes:
+// ------
+// - One wheel tick is 2^TMR_SHIFT SysTick ticks (65.5ms at 8MHz), timers expire
+//   on the first wheel step after their time, i.e. up to one tick late.
+// - Callbacks run in the scheduler task and may start and stop any timer. Long or
+//   blocking work (e.g. standby) belongs in a task that the callback signals.
+// - TMR_stat.max holds the longest wheel step in SysTick ticks without the time
+//   spent in the callbacks, TMR_stat.steps the number of steps. tools/tmr_bench.c
+//   measures the step cost on the PC for different numbers of running timers with
+//   one expiry per step: about 250ns with 1 timer and 330ns with 250 timers (about
+//   8 per bucket). Every further expired timer adds its own relink and callback.
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "system.h"
+#include "sched.h"
+
+// ===================================================================================
+// Timer Wheel Settings
+// ===================================================================================
+#ifndef TMR_POOL
+#define TMR_POOL          8                   // number of timers in pool (max 250)
+#endif
+#define TMR_SLOT_BITS     5                   // 2^n buckets (32)
+#define TMR_SHIFT         19                  // wheel tick = 2^n SysTick ticks
+
+// ===================================================================================
+// Timer Wheel Functions
+// ===================================================================================
+#define TMR_SLOTS         (1 << TMR_SLOT_BITS)
+#define TMR_TICK          ((uint32_t)1 << TMR_SHIFT)
+#define TMR_NONE          0xFF
+#define TMR_MS(n)         ((uint32_t)(((uint64_t)(n) * DLY_MS_TIME + TMR_TICK - 1) >> TMR_SHIFT))
+
+typedef void (*TMR_func_t)(void);
+
+typedef struct {
+  uint32_t max;                               // longest wheel step (w/o callbacks)
+  uint32_t steps;                             // number of wheel steps
+} TMR_stat_t;
+
+extern volatile TMR_stat_t TMR_stat;          // statistics for debug read-out
+
+void    TMR_init(uint8_t task);               // init timer wheel
+uint8_t TMR_new(TMR_func_t func);             // get timer from pool
+void    TMR_in(uint8_t id, uint32_t ticks);   // run timer once
+void    TMR_every(uint8_t id, uint32_t ticks);// run timer periodically
+void    TMR_stop(uint8_t id);                 // stop timer
+
+#ifdef __cplusplus
+};
+#endif
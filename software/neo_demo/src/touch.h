@@ -0,0 +1,63 @@
+// ===================================================================================
+// Capacitive Touch Sensor for CH32V003                                       * v1.0 *
+// ===================================================================================
+//
+// Senses a touch pad (a copper area or wire behind the housing) connected to an
+// ADC capable pin without any external components (capacitive voltage divider):
+// the pad is discharged to ground, the ADC sample capacitor is charged to Vref by
+// a conversion of the internal reference, then the floating pad is connected to the
+// ADC. The charge is shared between both capacitors, a finger on the pad adds
+// capacitance and lowers the result. A slowly tracking baseline compensates for
+// temperature, supply and housing changes, a touch is detected if the reading drops
+// more than TOUCH_THRESHOLD below it. The ADC is only powered during a scan.
+//
+// Functions available:
+// --------------------
+// TOUCH_init()             init ADC and pin, calibrate baseline (pad not touched)
+// TOUCH_read()             one scan, sum of TOUCH_SAMPLES conversions
+// TOUCH_sense()            scan, track baseline and return touch state (1: touched)
+//
+// TOUCH_ticks              duration of the last scan in SysTick ticks (active time)
+//
+// Notes:
+// ------
+// - Only PA1, PA2, PC4, PD2, PD3, PD4, PD5 and PD6 can be used as touch pin.
+// - TOUCH_THRESHOLD depends on the size of the pad and the thickness of the housing.
+//   Read TOUCH_read() with and without touch in the debugger to adjust it.
+// - The sampling time of the ADC is restored after each scan, so other ADC users
+//   (e.g. battery voltage measurement) are not affected.
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "config.h"
+#include "system.h"
+#include "gpio.h"
+
+// ===================================================================================
+// Touch Sensor Settings
+// ===================================================================================
+#define TOUCH_PIN         PIN_KEY             // touch pad pin (see config.h)
+#define TOUCH_SAMPLES     4                   // conversions per scan
+#define TOUCH_THRESHOLD   40                  // drop below baseline for touch
+#define TOUCH_HYST        12                  // hysteresis for release
+#define TOUCH_DRIFT       4                   // baseline filter (2^n scans)
+#define TOUCH_STUCK       255                 // scans until a touch is recalibrated
+
+// ===================================================================================
+// Touch Sensor Functions
+// ===================================================================================
+extern volatile uint16_t TOUCH_ticks;         // duration of last scan in ticks
+
+void     TOUCH_init(void);                    // init and calibrate
+uint16_t TOUCH_read(void);                    // raw scan value
+uint8_t  TOUCH_sense(void);                   // touch state with baseline tracking
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,134 @@
+// ===================================================================================
+// Fixed-Point Waveform Functions for CH32V003                                * v1.0 *
+// ===================================================================================
+//
+// Sine, cosine, triangle and easing functions for smooth animations without libm.
+// The RV32EC core has no hardware multiplier, so all functions only use table
+// lookups, shifts and additions. A single quarter-wave table (65 x 16-bit, 130 bytes
+// of flash) serves both the 8-bit and the 16-bit sine functions.
+//
+// Functions available:
+// --------------------
+// sin8(theta)              8-bit sine,   theta 0..255 = 0..360°, returns 1..255      (*)
+// cos8(theta)              8-bit cosine, theta 0..255 = 0..360°, returns 1..255      (*)
+// sin16(theta)             16-bit sine,   theta 0..65535 = 0..360°, returns +/-32767
+// cos16(theta)             16-bit cosine, theta 0..65535 = 0..360°, returns +/-32767
+// tri8(theta)              8-bit triangle wave, theta 0..255, returns 0..254
+// ease8(x)                 8-bit ease-in/ease-out (piecewise linear approximation)
+// quad8(theta)             8-bit sine-like wave (eased triangle), returns 0..255
+// scale8(x, s)             scale x by s/256 (shift/add multiplication)
+//
+// Cycle counts (approximate, -Os, RV32EC, 0 wait states at 8MHz):
+// ---------------------------------------------------------------
+// sin8/cos8 ~15 cycles, tri8/ease8/quad8 ~10 cycles, scale8 ~40 cycles,
+// sin16/cos16 ~25 cycles without and ~70 cycles with interpolation.
+//
+// Notes:
+// ------
+// - (*) sin8(0) = 128, sin8(64) = 255, sin8(192) = 1
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// ===================================================================================
+// Quarter-Wave Sine Table (32767 * sin(i * 90° / 64), i = 0..64)
+// ===================================================================================
+static const uint16_t WAVE_table[65] = {
+      0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+   6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+  27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+  32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767
+};
+
+// ===================================================================================
+// Helper Functions
+// ===================================================================================
+
+// Multiply a 16-bit value with an 8-bit factor and divide by 256 (shift/add)
+static inline uint16_t WAVE_mul8(uint16_t val, uint8_t fac) {
+  uint32_t result = 0;
+  uint32_t add    = val;
+  while(fac) {
+    if(fac & 1) result += add;
+    add <<= 1;
+    fac >>= 1;
+  }
+  return(result >> 8);
+}
+
+// Scale x by s/256
+static inline uint8_t scale8(uint8_t x, uint8_t s) {
+  return(WAVE_mul8(x, s));
+}
+
+// ===================================================================================
+// Sine and Cosine Functions
+// ===================================================================================
+
+// 8-bit sine: theta 0..255 represents 0..360°, returns 128 +/- 127
+static inline uint8_t sin8(uint8_t theta) {
+  uint8_t idx = theta & 63;
+  if(theta & 64)  idx = 64 - idx;
+  uint8_t val = WAVE_table[idx] >> 8;
+  return((theta & 128) ? (128 - val) : (128 + val));
+}
+
+// 8-bit cosine: theta 0..255 represents 0..360°, returns 128 +/- 127
+static inline uint8_t cos8(uint8_t theta) {
+  return(sin8(theta + 64));
+}
+
+// 16-bit sine: theta 0..65535 represents 0..360°, returns -32767..32767
+static inline int16_t sin16(uint16_t theta) {
+  uint16_t x = theta & 0x3FFF;
+  if(theta & 0x4000) x = 0x4000 - x;
+  uint8_t  idx  = x >> 8;
+  uint8_t  frac = x & 0xFF;
+  uint16_t val  = WAVE_table[idx];
+  if(frac) val += WAVE_mul8(WAVE_table[idx + 1] - val, frac);
+  return((theta & 0x8000) ? -(int16_t)val : (int16_t)val);
+}
+
+// 16-bit cosine: theta 0..65535 represents 0..360°, returns -32767..32767
+static inline int16_t cos16(uint16_t theta) {
+  return(sin16(theta + 0x4000));
+}
+
+// ===================================================================================
+// Triangle and Easing Functions
+// ===================================================================================
+
+// 8-bit triangle wave: 0..127 rising, 128..255 falling, returns 0..254
+static inline uint8_t tri8(uint8_t theta) {
+  if(theta & 128) theta = 255 - theta;
+  return(theta << 1);
+}
+
+// 8-bit ease-in/ease-out, piecewise linear approximation of a smoothstep curve
+static inline uint8_t ease8(uint8_t x) {
+  if(x < 64)        return(x >> 1);
+  if(x > 255 - 64)  return(255 - ((255 - x) >> 1));
+  x -= 64;
+  return(x + (x >> 1) + 32);
+}
+
+// 8-bit sine-like wave built from an eased triangle, returns 0..255
+static inline uint8_t quad8(uint8_t theta) {
+  return(ease8(tri8(theta)));
+}
+
+#ifdef __cplusplus
+};
+#endif
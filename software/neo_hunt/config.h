@@ -15,6 +15,7 @@
 // Pin definitions
 #define PIN_NEO           PC1         // pin connected to NeoPixels
 #define PIN_KEY           PC4         // pin connected to push button
+#define KEY_TOUCH         0           // 1: touch pad on PIN_KEY instead of button
 
 // NeoPixel definitions
 #define NEO_COUNT         16          // number of NeoPixels
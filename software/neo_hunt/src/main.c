@@ -39,6 +39,9 @@
 #include <config.h>                   // user configurations
 #include <system.h>                   // system functions
 #include <gpio.h>                     // GPIO functions
+#include <sched.h>                    // task scheduler
+#include <key.h>                      // button driver
+#include <lat.h>                      // latency recorder
 
 // ===================================================================================
 // NeoPixel Functions
@@ -109,75 +112,149 @@ void NEO_fillColor(uint32_t color) {
   for(uint8_t i=0; i<NEO_COUNT; i++) NEO_sendColor(color);
 }
 
+// Latch time and SysTick time of the end of the last transmission
+#define NEO_LATCH       SCHED_US(300)
+uint32_t NEO_done;
+
+// Wait until the last transmitted colors are latched (returns right away if so)
+void NEO_latch(void) {
+  DLY_since(NEO_done, NEO_LATCH);
+}
+
+// Fill all pixel with the same color (interrupts blocked during transmission)
+void NEO_fill(uint32_t color) {
+  NEO_latch();
+  INT_ATOMIC_BLOCK {
+    LAT_record(LAT_WAKE, SCHED_wakeTime());     // wake-up to first byte latency
+    NEO_fillColor(color);
+  }
+  NEO_done = STK->CNT;
+  SYS_bootFrame();                              // first frame after reset
+}
+
 // Init NeoPixel pin
 void NEO_init(void) {
   PIN_output(PIN_NEO);
+  NEO_done = 0;                                 // latch time counts from reset
 }
 
 // ===================================================================================
 // Game Functions
 // ===================================================================================
 
+// Task slots (run in this order: a press is judged before a due hunter step)
+#define TASK_KEYTIMER   0                       // button driver timer
+#define TASK_KEY        1                       // evaluate button events
+#define TASK_STEP       2                       // move hunter one step
+
 // Global variables
 uint8_t  hunter = 0;                            // current LED position of hunter
+uint8_t  last;                                  // previous LED position of hunter
 uint8_t  deer;                                  // current LED position of deer
 uint8_t  dir;                                   // current direction of hunter
 uint32_t speed;                                 // current delay between hunter steps
-uint32_t end;                                   // next SysTick counter for hunter step
+uint32_t moved;                                 // SysTick time of last hunter step
+uint32_t due;                                   // SysTick time of next hunter step
+
+#define GAME_NONE       0xFF                    // no previous hunter position
 
 // Update game on NeoPixel display
 void GAME_update(void) {
   uint32_t color;
-  DLY_us(300);                                  // make sure last colors latched
-  for(uint8_t i=0; i<NEO_COUNT; i++) {          // all LEDs:
-    if(i == hunter)    color = NEO_GREEN;       // set green LED for hunter
-    else if(i == deer) color = NEO_RED;         // set red LED for deer
-    else               color = NEO_BLACK;       // turn LED off otherwise
-    NEO_sendColor(color);                       // send color to LED
+  NEO_latch();                                  // make sure last colors latched
+  INT_ATOMIC_BLOCK {
+    LAT_record(LAT_WAKE, SCHED_wakeTime());     // wake-up to first byte latency
+    LAT_stop(LAT_FRAME);                        // button edge to frame latency
+    for(uint8_t i=0; i<NEO_COUNT; i++) {        // all LEDs:
+      if(i == hunter)    color = NEO_GREEN;     // set green LED for hunter
+      else if(i == deer) color = NEO_RED;       // set red LED for deer
+      else               color = NEO_BLACK;     // turn LED off otherwise
+      NEO_sendColor(color);                     // send color to LED
+    }
   }
-  end = STK->CNT + speed;                       // calculate time for next hunter step
+  NEO_done = STK->CNT;
+}
+
+// Schedule next hunter step, hunter position is valid from SysTick time start
+void GAME_schedule(uint32_t start) {
+  moved = start;
+  due   = start + speed;
+  SCHED_at(TASK_STEP, due);                     // drift-free hunter steps
 }
 
 // Reset game
 void GAME_reset(void) {
-  DLY_us(300);                                  // make sure last colors latched
-  NEO_fillColor(NEO_BLUE);                      // set all LEDs to blue
-  DLY_ms(100);                                  // wait a bit
+  LAT_stop(LAT_FRAME);                          // button edge to frame latency
+  NEO_fill(NEO_BLUE);                           // set all LEDs to blue
+  ALM_wait_ms(100);                             // wait a bit (sleeping)
   deer  = (hunter + 4 + (STK->CNT & 7)) & 15;   // next position of deer
   dir   = !dir;                                 // revert hunter direction
+  last  = GAME_NONE;                            // new round: no previous position
   speed = GAME_SPEED_START * DLY_MS_TIME;       // set hunter speed for game start
   GAME_update();                                // update game display
+  GAME_schedule(SCHED_now());                   // schedule first hunter step
+}
+
+// Get next position of hunter
+uint8_t GAME_ahead(void) {
+  return (dir ? hunter + 1 : hunter - 1) & 15;
+}
+
+// Get position of hunter at SysTick time (GAME_NONE: before current round)
+uint8_t GAME_hunterAt(uint32_t time) {
+  if((int32_t)(time - moved) < 0) return last;  // before last step
+  if((int32_t)(time - due) < 0) return hunter;  // current position
+  return GAME_ahead();                          // step due, but not run yet
+}
+
+// Evaluate button events (signaled by button driver)
+void GAME_key(void) {
+  uint8_t event, pos;
+  while((event = KEY_get()) != KEY_NONE) {
+    if(event != KEY_PRESS) continue;            // only react on key press
+    pos = GAME_hunterAt(KEY_time());            // judge position at time of press
+    if(pos == GAME_NONE) continue;              // pressed before this round
+    LAT_record(LAT_DECIDE, KEY_time());         // button edge to decision latency
+    LAT_start(LAT_FRAME, KEY_time());
+    if(pos == deer) {                           // catched the deer?
+      hunter = pos;
+      deer   = (hunter + 4 + (STK->CNT & 7)) & 15;  // next position of deer
+      dir    = !dir;                            // revert hunter direction
+      last   = GAME_NONE;                       // new round: no previous position
+      speed -= GAME_SPEED_INC * DLY_MS_TIME;    // increase hunter speed
+      GAME_update();                            // update game display
+      GAME_schedule(SCHED_now());               // restart hunter steps
+    }
+    else GAME_reset();                          // missed deer? -> reset game
+  }
+}
+
+// Move hunter one step (SysTick compare task)
+void GAME_step(void) {
+  GAME_key();                                   // judge queued presses first
+  if((int32_t)(SCHED_now() - due) < 0) return;  // caught or reset meanwhile
+  if(hunter == deer) GAME_reset();              // missed deer? -> reset game
+  else {
+    last   = hunter;                            // move hunter
+    hunter = GAME_ahead();
+    GAME_update();                              // update game display
+    GAME_schedule(due);                         // step time as scheduled
+  }
 }
 
-// Main function
+// ===================================================================================
+// Main Function
+// ===================================================================================
 int main(void) {
   // Setup
-  PIN_input_PU(PIN_KEY);                        // set button pin to input pullup
   NEO_init();                                   // init Neopixels
-  GAME_reset();                                 // reset game parameters
+  SCHED_init();                                 // init scheduler
+  LAT_init();                                   // init latency statistics
+  SCHED_set(TASK_STEP, GAME_step);              // attach game tasks
+  SCHED_set(TASK_KEY, GAME_key);
+  GAME_reset();                                 // reset game, show first frame
+  KEY_init(TASK_KEYTIMER, TASK_KEY);            // init button driver afterwards
 
   // Loop
-  while(1) {
-    if(((int32_t)(STK->CNT - end)) >= 0) {      // next step?
-      if(hunter == deer) GAME_reset();          // missed deer? -> reset game
-      else {
-        if(dir) hunter++;                       // move hunter
-        else hunter--;
-        hunter &= 15;
-        GAME_update();                          // update game display
-      }
-    }
-
-    if(!PIN_read(PIN_KEY)) {                          // key pressed?
-      if(hunter == deer) {                            // catched the deer?
-        deer   = (hunter + 4 + (STK->CNT & 7)) & 15;  // next position of deer
-        dir    = !dir;                                // revert hunter direction
-        speed -= GAME_SPEED_INC * DLY_MS_TIME;        // increase hunter speed
-        GAME_update();                                // update game display
-      }
-      else GAME_reset();                              // missed deer? -> reset game
-      while(!PIN_read(PIN_KEY));                      // wait for key released
-      DLY_ms(10);                                     // debounce key
-    }
-  }
+  while(1) SCHED_run();                         // run tasks, sleep in between
 }
@@ -0,0 +1,88 @@
+// ===================================================================================
+// Tickless Event-Driven Scheduler for CH32V003                               * v1.0 *
+// ===================================================================================
+//
+// Runs a small, fixed number of tasks at SysTick times. There is no periodic tick:
+// the scheduler programs the SysTick compare register for the next due task and
+// sleeps until then. Waits of SCHED_STDBY_MS or longer are spent in standby, woken
+// up by the automatic wake-up timer (AWU). The AWU period is rounded down to its
+// prescaler step and limited to 30.7s, the scheduler advances SysTick by the period
+// really set and sleeps again for the rest. Interrupts (e.g. pin change via EXTI)
+// wake up the scheduler at any time and can request a task with SCHED_signal().
+//
+// Functions available:
+// --------------------
+// SCHED_init()             init scheduler (call once before using it)
+// SCHED_set(id, func)      attach task function to task slot id
+// SCHED_in(id, ticks)      run task id in ticks from now
+// SCHED_at(id, time)       run task id at SysTick time
+// SCHED_next(id, ticks)    run task id ticks after its last due time (drift-free)
+// SCHED_stop(id)           stop timer of task id
+// SCHED_signal(id)         run task id as soon as possible (can be called in ISR)
+// SCHED_keep(mask)         pins (PWR_KEEP) that keep their configuration in standby
+// SCHED_run()              run due tasks or sleep until next event (call in loop)
+//
+// SCHED_now()              current SysTick time
+// SCHED_wakeTime()         SysTick time of last wake-up (end of last idle phase)
+// SCHED_woke()             set wake-up time to now (after a standby outside of
+//                          SCHED_run(), e.g. KEY_sleep())
+// SCHED_US(n)              convert n microseconds to ticks
+// SCHED_MS(n)              convert n milliseconds to ticks
+//
+// Notes:
+// ------
+// - Requires SYS_USE_VECTORS and SYS_TICK_INIT in system.h. Uses the SysTick alarm
+//   (ALM_sleep) to wake up. It is stopped while the tasks run, so a task may use
+//   ALM_wait() as a low-power delay (e.g. the reset flash of neo_hunt), but must not
+//   start an alarm with ALM_start(), which the next sleep would replace.
+// - The SysTick counter stops in standby. It is advanced by the AWU period after
+//   wake-up if the AWU flag (EXTI line 9) shows that the period has run out.
+// - Enabled pin interrupts are armed as wake-up events during standby, so a pin
+//   edge ends the standby right away and its ISR runs with the time of the edge.
+//   The time slept until then is lost (less than one standby period): pending
+//   timers are delayed by it and durations across the standby appear shorter.
+// - Standby timing depends on the accuracy of the internal low-speed clock (LSI).
+// - All pins not set with SCHED_keep() are switched to analog input during standby
+//   (see PWR_save). By default, all pins are kept.
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "system.h"
+
+// ===================================================================================
+// Scheduler Settings
+// ===================================================================================
+#define SCHED_TASKS       4                   // number of task slots (max 8)
+#define SCHED_STDBY       0                   // 1: use standby for long waits
+#define SCHED_STDBY_MS    8                   // minimum wait in ms for standby
+
+// ===================================================================================
+// Scheduler Functions
+// ===================================================================================
+#define SCHED_now()       (STK->CNT)
+#define SCHED_US(n)       ((uint32_t)(n) * DLY_US_TIME)
+#define SCHED_MS(n)       ((uint32_t)(n) * DLY_MS_TIME)
+
+typedef void (*SCHED_func_t)(void);
+
+void SCHED_init(void);                                  // init scheduler
+void SCHED_set(uint8_t id, SCHED_func_t func);          // attach task function
+void SCHED_at(uint8_t id, uint32_t time);               // run task at SysTick time
+void SCHED_in(uint8_t id, uint32_t ticks);              // run task in ticks from now
+void SCHED_next(uint8_t id, uint32_t ticks);            // run task ticks after last due
+void SCHED_stop(uint8_t id);                            // stop task timer
+void SCHED_signal(uint8_t id);                          // request task immediately
+void SCHED_keep(uint32_t mask);                         // pins kept in standby
+void SCHED_run(void);                                   // run due tasks or sleep
+uint32_t SCHED_wakeTime(void);                          // time of last wake-up
+void SCHED_woke(void);                                  // set wake-up time to now
+
+#ifdef __cplusplus
+};
+#endif
@@ -13,6 +13,10 @@
 // CLK_init_HSE_PLL()       init external crystal (PLL) as system clock source
 // CLK_reset()              reset system clock to default state
 //
+// CLK_fast()               switch to 48MHz at runtime (needs SYS_CLK_SWITCH, F_CPU 8MHz)
+// CLK_slow()               switch back to F_CPU at runtime
+// CLK_isFast()             check if system runs at 48MHz
+//
 // HSI_enable()             enable internal 8MHz high-speed clock (HSI)
 // HSI_disable()            disable HSI
 // HSI_ready()              check if HSI is stable
@@ -44,6 +48,55 @@
 // DLY_ticks(n)             delay n clock cycles
 // DLY_us(n)                delay n microseconds
 // DLY_ms(n)                delay n milliseconds
+// DLY_since(start, n)      wait until n system ticks have passed since SysTick time
+//                          start (returns immediately if they already have)
+//
+// Alarm (ALM) functions available (SysTick compare, needs SYS_USE_VECTORS):
+// ---------------------------------------------------------------------------
+// ALM_init()               enable SysTick interrupt (call once before using alarm)
+// ALM_start(t, p, func)    fire at SysTick time t, then every p ticks (p = 0: once),
+//                          func is called in the interrupt (NULL: wake-up only)
+// ALM_in(n, p, func)       fire in n ticks, then every p ticks (p = 0: once)
+// ALM_stop()               stop alarm
+// ALM_fired()              check if alarm has fired since last start
+// ALM_sleep(t)             sleep until SysTick time t or any other interrupt
+//                          (call with interrupts disabled, e.g. by scheduler)
+// ALM_wait(t)              sleep until SysTick time t, serving other interrupts
+// ALM_wait_us(n)           sleep n microseconds (low-power delay)
+// ALM_wait_ms(n)           sleep n milliseconds (low-power delay)
+//
+// Notes:
+// ------
+// - With SYS_CLK_SWITCH the SysTick counter keeps its F_CPU time base across clock
+//   switches: it runs with HCLK/8 (6MHz) while fast and the missing ticks are added
+//   when switching back. Delays are scaled while fast. SysTick times taken before
+//   and after a fast period can be compared, but the fast period must end before
+//   the device goes to sleep (SysTick compare values are not scaled).
+// - With SYS_USE_VTF, ALM_init() binds the SysTick interrupt to VTF slot
+//   VTF_SLOT_ALARM and the button driver binds the pin interrupt to VTF_SLOT_PIN.
+//   The core then jumps to the handler directly instead of loading its address from
+//   the vector table. Together with the hardware prologue/epilogue (HPE, enabled in
+//   reset_handler via CSR 0x804) this shortens the interrupt entry.
+// - With SYS_IRQ_LATENCY, the SysTick handler records the ticks from the compare
+//   match to its first statement in ALM_lat (last and max, debugger read-out). This
+//   includes the wake-up from sleep and the register saving of the handler. Compare
+//   the values with SYS_USE_VTF 0 and 1.
+// - SYS_TICK_INIT starts the SysTick counter first thing in reset_handler, so SysTick
+//   times count from the start of the firmware. With SYS_BOOT_TIME, reset_handler
+//   records the end of the RAM setup and the entry into main() in SYS_boot, and the
+//   firmware records its first frame with SYS_bootFrame() (debugger read-out). The
+//   hardware power-on reset delay before reset_handler is not included.
+// - The clock setup is skipped if the reset clock is already F_CPU (HSI/3 = 8MHz).
+// - There is only one alarm: ALM_sleep() and ALM_wait() replace a running alarm.
+//   ALM_wait() keeps the interrupt state of the caller. Called with interrupts
+//   disabled, an interrupt that wakes it up stays pending and the rest of the wait
+//   is a busy loop.
+//   Alarm times have the resolution of one SysTick (125ns at 8MHz), but waking
+//   up from sleep takes a few cycles more.
+// - DLY_us(n) and DLY_ms(n) with a constant n are inlined: up to DLY_NOP_MAX ticks
+//   as a cycle-exact sequence of c.nop (only without SYS_CLK_SWITCH, flash needs no
+//   wait state at 8MHz), longer delays as a SysTick loop without function call
+//   (accurate to one loop pass of a few cycles). Variable delays call DLY_ticks().
 //
 // Reset (RST) and Bootloader (BOOT) functions available:
 // ------------------------------------------------------
@@ -56,6 +109,7 @@
 // RST_wasSoftware()        check if last reset was caused by software
 // RST_wasPower()           check if last reset was caused by power up
 // RST_wasPin()             check if last reset was caused by RST pin low
+// SYS_bootFrame()          record SysTick time of the first frame (SYS_BOOT_TIME)
 //
 // Independent Watchdog Timer (IWDG) functions available:
 // ------------------------------------------------------
@@ -68,6 +122,7 @@
 // AWU_start(n)             start AWU with n milliseconds period and event trigger
 // AWU_stop()               stop AWU and event trigger
 // AWU_set(n)               set AWU period to n milliseconds
+// AWU_period(n)            AWU period in ms actually set by AWU_set(n)
 //
 // AWU_enable()             enable AWU (without LSI and PWR module)
 // AWU_disable()            disable AWU (without LSI and PWR module)
@@ -88,6 +143,10 @@
 // SLEEP_ms(n)              put device into SLEEP for n milliseconds (uses AWU)
 // STDBY_ms(n)              put device into STANDBY for n milliseconds (uses AWU)
 //
+// PWR_save(keep)           set all pins except keep to analog input, gate clocks
+// PWR_restore()            restore pins and clocks after wake-up
+// PWR_KEEP(PIN)            pin bitmask for PWR_save (e.g. PWR_KEEP(PC1)|PWR_KEEP(PC4))
+//
 // Programmable Voltage Detector (PVD) functions available:
 // --------------------------------------------------------
 // PVD_enable()             enable PVD
@@ -106,6 +165,8 @@
 // INT_enable()             global interrupt enable
 // INT_disable()            global interrupt disable
 // INT_ATOMIC_BLOCK { }     execute block without being interrupted
+// INT_VTF_bind(n, irq, f)  bind interrupt irq to vector-table-free slot n (0..1)
+// INT_VTF_unbind(n)        release VTF slot n (interrupt uses vector table again)
 //
 // References:
 // -----------
@@ -129,8 +190,12 @@ extern "C" {
 #define SYS_TICK_INIT     1         // 1: init and start SYSTICK on startup
 #define SYS_GPIO_EN       1         // 1: enable GPIO ports on startup
 #define SYS_CLEAR_BSS     0         // 1: clear uninitialized variables
-#define SYS_USE_VECTORS   0         // 1: create interrupt vector table
+#define SYS_USE_VECTORS   1         // 1: create interrupt vector table
 #define SYS_USE_HSE       0         // 1: use external crystal
+#define SYS_CLK_SWITCH    0         // 1: enable runtime switching to 48MHz
+#define SYS_USE_VTF       0         // 1: bind hot interrupts to VTF slots
+#define SYS_IRQ_LATENCY   0         // 1: record SysTick interrupt entry latency
+#define SYS_BOOT_TIME     0         // 1: record boot times in SYS_boot
 
 // ===================================================================================
 // Sytem Clock Defines
@@ -177,6 +242,12 @@ extern "C" {
   #define F_CPU           48000000
 #endif
 
+#if (SYS_CLK_SWITCH > 0) && ((F_CPU != 8000000) || (SYS_USE_HSE > 0))
+  #warning Runtime clock switching needs F_CPU 8MHz from HSI, disabled
+  #undef  SYS_CLK_SWITCH
+  #define SYS_CLK_SWITCH  0
+#endif
+
 #if SYS_USE_HSE > 0
   #ifdef SYS_USE_PLL
     #define CLK_init      CLK_init_HSE_PLL
@@ -200,6 +271,16 @@ void CLK_init_HSE(void);      // init external crystal (non PLL) as system clock
 void CLK_init_HSE_PLL(void);  // init external crystal (PLL) as system clock source
 void CLK_reset(void);         // reset system clock to default state
 
+#if SYS_CLK_SWITCH > 0
+void CLK_fast(void);          // switch system clock to 48MHz at runtime
+void CLK_slow(void);          // switch system clock back to F_CPU at runtime
+#define CLK_isFast()      ((RCC->CFGR0 & RCC_SWS) == RCC_SWS_PLL)
+#else
+#define CLK_fast()
+#define CLK_slow()
+#define CLK_isFast()      0
+#endif
+
 // Internal 8MHz high-speed clock (HSI) functions
 #define HSI_enable()      RCC->CTLR |= RCC_HSION        // enable HSI
 #define HSI_disable()     RCC->CTLR &= ~RCC_HSION       // disable HSI
@@ -238,10 +319,56 @@ void MCO_init(void);                                    // init clock output to
 #define STK_init()        STK->CTLR = STK_CTLR_STE | STK_CTLR_STCLK // init SYSTICK @ F_CPU
 #define DLY_US_TIME       (F_CPU / 1000000)                   // system ticks per us
 #define DLY_MS_TIME       (F_CPU / 1000)                      // system ticks per ms
-#define DLY_us(n)         DLY_ticks((n) * DLY_MS_TIME / 1000) // delay n microseconds
-#define DLY_ms(n)         DLY_ticks((n) * DLY_MS_TIME)        // delay n milliseconds
+#define DLY_NOP_MAX       16                                  // max ticks as nops
 void DLY_ticks(uint32_t n);                                   // delay n system ticks
 
+// Delay n system ticks without function call (for constant n)
+static inline __attribute__((always_inline)) void DLY_inline(uint32_t n) {
+  #if SYS_CLK_SWITCH == 0
+  if(__builtin_constant_p(n) && (n <= DLY_NOP_MAX)) {
+    asm volatile(".rept %0 \n c.nop \n .endr" : : "i" (n));  // 1 cycle per c.nop
+    return;
+  }
+  #else
+  if(CLK_isFast()) n -= n >> 2;                               // SysTick @ 6MHz
+  #endif
+  uint32_t end = STK->CNT + n;
+  while(((int32_t)(STK->CNT - end)) < 0);
+}
+
+// Wait until n system ticks have passed since SysTick time start
+static inline void DLY_since(uint32_t start, uint32_t n) {
+  while((STK->CNT - start) < n);
+}
+
+#define DLY_us(n)         (__builtin_constant_p(n) ? DLY_inline((n) * DLY_MS_TIME / 1000) \
+                                                   : DLY_ticks((n) * DLY_MS_TIME / 1000))
+#define DLY_ms(n)         (__builtin_constant_p(n) ? DLY_inline((n) * DLY_MS_TIME) \
+                                                   : DLY_ticks((n) * DLY_MS_TIME))
+
+// ===================================================================================
+// Alarm (ALM) Functions (SysTick Compare)
+// ===================================================================================
+typedef void (*ALM_func_t)(void);
+
+typedef struct {
+  uint32_t last;                                        // last entry latency in ticks
+  uint32_t max;                                         // max entry latency in ticks
+} ALM_lat_t;
+
+extern volatile ALM_lat_t ALM_lat;                      // SYS_IRQ_LATENCY read-out
+
+#define ALM_in(n, p, f)   ALM_start(STK->CNT + (n), p, f)
+#define ALM_stop()        STK->CTLR &= ~STK_CTLR_STIE
+#define ALM_wait_us(n)    ALM_wait(STK->CNT + (uint32_t)(n) * DLY_US_TIME)
+#define ALM_wait_ms(n)    ALM_wait(STK->CNT + (uint32_t)(n) * DLY_MS_TIME)
+
+void    ALM_init(void);                                 // enable SysTick interrupt
+void    ALM_start(uint32_t time, uint32_t period, ALM_func_t func); // start alarm
+uint8_t ALM_fired(void);                                // alarm fired since start?
+void    ALM_sleep(uint32_t time);                       // sleep until time or interrupt
+void    ALM_wait(uint32_t time);                        // sleep until time
+
 // ===================================================================================
 // Reset (RST) Functions
 // ===================================================================================
@@ -254,6 +381,23 @@ void DLY_ticks(uint32_t n);                                   // delay n system
 #define RST_wasPower()    (RCC->RSTSCKR & RCC_PORRSTF)
 #define RST_wasPin()      (RCC->RSTSCKR & RCC_PINRSTF)
 
+// ===================================================================================
+// Boot Time Recording (SYS_BOOT_TIME)
+// ===================================================================================
+typedef struct {
+  uint32_t init;                                        // RAM setup done
+  uint32_t main;                                        // entry into main()
+  uint32_t frame;                                       // end of first frame
+} SYS_boot_t;
+
+extern volatile SYS_boot_t SYS_boot;                    // SYS_BOOT_TIME read-out
+
+#if SYS_BOOT_TIME > 0
+#define SYS_bootFrame()   do { if(!SYS_boot.frame) SYS_boot.frame = STK->CNT; } while(0)
+#else
+#define SYS_bootFrame()
+#endif
+
 // ===================================================================================
 // Bootloader (BOOT) Functions
 // ===================================================================================
@@ -299,6 +443,18 @@ void AWU_stop(void);        // stop automatic wake-up timer
   (ms < 30720 ? ({PWR->AWUPSC = 0b1111; PWR->AWUWR = (ms)/480;}) : \
   (0)))))))))
 
+// AWU period in milliseconds set by AWU_set(ms) (rounded down to the prescaler step)
+#define AWU_period(ms) \
+  (ms <    64 ? (ms)            : \
+  (ms <   128 ? ((ms)>>1)<<1    : \
+  (ms <   256 ? ((ms)>>2)<<2    : \
+  (ms <   512 ? ((ms)>>3)<<3    : \
+  (ms <  1024 ? ((ms)>>4)<<4    : \
+  (ms <  2048 ? ((ms)>>5)<<5    : \
+  (ms <  5120 ? (ms)/80*80      : \
+  (ms < 30720 ? (ms)/480*480    : \
+  (0)))))))))
+
 // ===================================================================================
 // Sleep Functions
 // ===================================================================================
@@ -310,6 +466,12 @@ void STDBY_WFE_now(void);   // put device into standby (deep sleep), wake up eve
 #define SLEEP_ms(n)           {AWU_start(n); SLEEP_WFE_now(); AWU_stop();}
 #define STDBY_ms(n)           {AWU_start(n); STDBY_WFE_now(); AWU_stop();}
 
+// Power saving around sleep/standby (kept pins keep their configuration and clock,
+// SWIO (PD1) is always kept, the ADC is powered down, only AFIO and PWR stay clocked)
+#define PWR_KEEP(PIN)         ((uint32_t)1 << (PIN))
+void PWR_save(uint32_t keep);   // set unused pins to analog input, gate clocks
+void PWR_restore(void);         // restore pins and clocks
+
 // ===================================================================================
 // Programmable Voltage Detector (PVD) Functions
 // ===================================================================================
@@ -341,6 +503,12 @@ void STDBY_WFE_now(void);   // put device into standby (deep sleep), wake up eve
 #define INT_ATOMIC_BLOCK      for(INT_ATOMIC_RESTORE, __ToDo = 1; __ToDo; __ToDo = 0)
 #define INT_ATOMIC_RESTORE    uint32_t __reg_save __attribute__((__cleanup__(__iRestore))) = __iSave()
 
+// Vector-table-free (VTF) interrupts (slots used with SYS_USE_VTF)
+#define VTF_SLOT_ALARM        0                         // SysTick alarm
+#define VTF_SLOT_PIN          1                         // pin interrupt (button)
+#define INT_VTF_bind(n, irq, f)   SetVTFIRQ((uint32_t)(f), irq, n, ENABLE)
+#define INT_VTF_unbind(n)         NVIC->VTFADDR[n] &= ~((uint32_t)1)
+
 // Save interrupt status and disable interrupts
 static inline uint32_t __iSave(void) {
   uint32_t result, temp;
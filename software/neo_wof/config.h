@@ -7,8 +7,12 @@
 // Pin definitions
 #define PIN_NEO         PC1           // pin connected to NeoPixels
 #define PIN_KEY         PC4           // pin connected to push button
+#define KEY_TOUCH       0             // 1: touch pad on PIN_KEY instead of button
 
 // NeoPixel definitions
 #define NEO_COUNT       16            // number of NeoPixels
 #define NEO_REFRESH     64            // NeoPixel refresh period in milliseconds
 #define NEO_AUTO_COUNT  76            // number of periods per animation in auto mode
+
+// Auto-off
+#define AUTO_OFF        60            // seconds after wheel stopped until off (0: never, max 260)
@@ -0,0 +1,207 @@
+// ===================================================================================
+// Non-Blocking Button Driver for CH32V003                                    * v1.0 *
+// ===================================================================================
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#include "key.h"
+
+// Driver state
+static uint8_t           KEY_timer;                     // scheduler slot of driver
+static uint8_t           KEY_task;                      // scheduler slot to signal
+static uint8_t           KEY_state;                     // debounced state (1: pressed)
+static uint8_t           KEY_check;                     // 1: debounce in progress
+static uint8_t           KEY_mute;                      // 1: drop events until release
+static uint32_t          KEY_pressed;                   // time of last press
+static uint32_t          KEY_released;                  // time of last release
+static volatile uint8_t  KEY_flag;                      // 1: new edge detected
+#if KEY_TOUCH == 0
+static volatile uint32_t KEY_edge;                      // time of first edge
+#endif
+
+// Event queue
+static uint8_t           KEY_type[KEY_QUEUE];           // event types
+static uint32_t          KEY_stamp[KEY_QUEUE];          // event times
+static uint8_t           KEY_head, KEY_count;           // queue read index and size
+static uint32_t          KEY_last;                      // time of last returned event
+
+#if KEY_TOUCH == 0
+// ===================================================================================
+// Pin Interrupt (first edge starts debounce)
+// ===================================================================================
+PIN_INT_ISR {
+  EXTI->INTFR   = KEY_BIT;                              // clear interrupt flag
+  EXTI->INTENR &= ~KEY_BIT;                             // ignore bounces
+  KEY_edge      = STK->CNT;                             // timestamp of edge
+  KEY_flag      = 1;
+  SCHED_signal(KEY_timer);                              // start debounce
+}
+#endif
+
+// ===================================================================================
+// Event Queue Functions
+// ===================================================================================
+
+// Put event into queue and signal event task (event is dropped if queue is full)
+static void KEY_put(uint8_t type, uint32_t time) {
+  uint8_t i;
+  if(KEY_mute || (KEY_count >= KEY_QUEUE)) return;
+  i = KEY_head + KEY_count++;
+  if(i >= KEY_QUEUE) i -= KEY_QUEUE;
+  KEY_type[i]  = type;
+  KEY_stamp[i] = time;
+  if(KEY_task != KEY_NOTASK) SCHED_signal(KEY_task);
+}
+
+// Get next event from queue
+uint8_t KEY_get(void) {
+  uint8_t type;
+  if(!KEY_count) return KEY_NONE;
+  type     = KEY_type[KEY_head];
+  KEY_last = KEY_stamp[KEY_head];
+  if(++KEY_head >= KEY_QUEUE) KEY_head = 0;
+  KEY_count--;
+  return type;
+}
+
+// Get SysTick time of the event last returned by KEY_get()
+uint32_t KEY_time(void) {
+  return KEY_last;
+}
+
+// Get debounced button state
+uint8_t KEY_isPressed(void) {
+  return KEY_state;
+}
+
+// Drop all events until the button has been released
+void KEY_ignore(void) {
+  KEY_mute = 1;
+}
+
+// ===================================================================================
+// Driver Task (debounce and long press timer)
+// ===================================================================================
+
+// Take over new button state and queue the matching events
+static void KEY_toggle(uint32_t time) {
+  KEY_state = !KEY_state;
+  if(KEY_state) {
+    KEY_put(KEY_PRESS, time);
+    if((time - KEY_released) < SCHED_MS(KEY_DOUBLE_MS)) KEY_put(KEY_DOUBLE, time);
+    KEY_pressed = time;
+  }
+  else {
+    KEY_put(KEY_RELEASE, time);
+    KEY_released = time;
+    KEY_mute     = 0;
+  }
+}
+
+#if KEY_TOUCH > 0
+// Driver task, scans touch pad periodically
+static void KEY_update(void) {
+  uint32_t now = STK->CNT;
+  SCHED_next(KEY_timer, SCHED_MS(KEY_SCAN_MS));         // drift-free scan period
+  if(TOUCH_sense() != KEY_state) {                      // touch state changed?
+    KEY_toggle(now);
+    KEY_check = KEY_state;                              // start long press timer
+  }
+  else if(KEY_check && ((now - KEY_pressed) >= SCHED_MS(KEY_LONG_MS))) {
+    KEY_check = 0;
+    KEY_put(KEY_LONG, now);
+  }
+}
+
+#else
+// Driver task, signaled by pin interrupt or run by timer
+static void KEY_update(void) {
+  // New edge: take over state right away, ignore bounces for debounce time
+  if(KEY_flag) {
+    KEY_flag  = 0;
+    KEY_check = 1;
+    KEY_toggle(KEY_edge);
+    SCHED_at(KEY_timer, KEY_edge + SCHED_MS(KEY_DEBOUNCE_MS));
+    return;
+  }
+
+  // Long press timer expired
+  if(!KEY_check) {
+    if(KEY_state) KEY_put(KEY_LONG, STK->CNT);
+    return;
+  }
+
+  // Debounce time over: catch up on a missed edge, start long press timer
+  KEY_check = 0;
+  if((uint8_t)!PIN_read(KEY_PIN) != KEY_state) KEY_toggle(STK->CNT);
+  if(KEY_state) SCHED_at(KEY_timer, KEY_pressed + SCHED_MS(KEY_LONG_MS));
+
+  // Enable interrupt again, restart debounce if an edge was missed meanwhile
+  INT_ATOMIC_BLOCK {
+    EXTI->INTFR   = KEY_BIT;
+    EXTI->INTENR |= KEY_BIT;
+    if(((uint8_t)!PIN_read(KEY_PIN) != KEY_state) && !KEY_flag) {
+      EXTI->INTENR &= ~KEY_BIT;
+      KEY_edge = STK->CNT;
+      KEY_flag = 1;
+      SCHED_signal(KEY_timer);
+    }
+  }
+}
+#endif
+
+// ===================================================================================
+// Standby Function
+// ===================================================================================
+
+// Put device into standby until the button is pressed
+void KEY_sleep(uint32_t keep) {
+  keep |= PWR_KEEP(KEY_PIN);
+  #if KEY_TOUCH > 0
+  AWU_init();                                           // wake up periodically
+  AWU_set(KEY_SLEEP_MS);
+  do {
+    PWR_save(keep);                                     // unused pins to analog
+    STDBY_WFE_now();                                    // standby until AWU event
+    PWR_restore();
+  } while(!TOUCH_sense());                              // scan touch pad
+  SCHED_woke();                                         // wake-up time for latency
+  AWU_disable();
+  #else
+  KEY_EVT_enable();                                     // wake up by button event
+  PWR_save(keep);                                       // unused pins to analog
+  do STDBY_WFE_now();                                   // standby until pressed
+  while(PIN_read(KEY_PIN));
+  SCHED_woke();                                         // wake-up time for latency
+  PWR_restore();
+  KEY_EVT_disable();
+  #endif
+}
+
+// ===================================================================================
+// Init Function
+// ===================================================================================
+void KEY_init(uint8_t timer, uint8_t task) {
+  KEY_timer    = timer;
+  KEY_task     = task;
+  KEY_check    = 0;
+  KEY_mute     = 0;
+  KEY_flag     = 0;
+  KEY_head     = 0;
+  KEY_count    = 0;
+  KEY_released = STK->CNT - SCHED_MS(KEY_DOUBLE_MS);
+  SCHED_set(timer, KEY_update);
+  #if KEY_TOUCH > 0
+  TOUCH_init();                                         // calibrate untouched pad
+  KEY_state    = 0;
+  SCHED_in(timer, SCHED_MS(KEY_SCAN_MS));               // start scanning
+  #else
+  PIN_input_PU(KEY_PIN);                                // input with pull-up
+  KEY_state    = !PIN_read(KEY_PIN);
+  PIN_INT_set(KEY_PIN, PIN_INT_BOTH);                   // interrupt on both edges
+  #if SYS_USE_VTF > 0
+  INT_VTF_bind(VTF_SLOT_PIN, EXTI7_0_IRQn, EXTI7_0_IRQHandler);  // fast entry
+  #endif
+  PIN_INT_enable();
+  #endif
+}
@@ -34,6 +34,10 @@
 #include <config.h>             // user configurations
 #include <system.h>             // system functions
 #include <gpio.h>               // GPIO functions
+#include <sched.h>              // task scheduler
+#include <lat.h>                // latency recorder
+#include <key.h>                // button driver
+#include <pt.h>                 // protothreads
 
 // ===================================================================================
 // NeoPixel Functions
@@ -100,53 +104,132 @@ void NEO_writeHue(uint8_t hue) {
   }
 }
 
-// Set a single pixel and clear the others
+// Latch time and SysTick time of the end of the last transmission
+#define NEO_LATCH       SCHED_US(300)
+uint32_t NEO_done;
+
+// Wait until the last transmitted colors are latched (returns right away if so)
+void NEO_latch(void) {
+  DLY_since(NEO_done, NEO_LATCH);
+}
+
+// Set a single pixel and clear the others (interrupts blocked during transmission)
 void NEO_setPixel(uint8_t nr, uint8_t hue) {
-  for(uint8_t i=0; i<NEO_COUNT; i++) {
-    (i==nr) ? (NEO_writeHue(hue)) : (NEO_writeColor(0,0,0));
+  NEO_latch();
+  INT_ATOMIC_BLOCK {
+    LAT_record(LAT_WAKE, SCHED_wakeTime());   // wake-up to first byte latency
+    LAT_stop(LAT_FRAME);                      // button edge to frame latency
+    for(uint8_t i=0; i<NEO_COUNT; i++) {
+      (i==nr) ? (NEO_writeHue(hue)) : (NEO_writeColor(0,0,0));
+    }
   }
+  NEO_done = STK->CNT;
+  SYS_bootFrame();                            // first frame after reset
 }
 
 // Init NeoPixel pin
 void NEO_init(void) {
   PIN_output(PIN_NEO);
-  DLY_us(300);
+  NEO_done = 0;                               // latch time counts from reset
+}
+
+// ===================================================================================
+// Wheel Functions
+// ===================================================================================
+
+// Task slots
+#define TASK_SPIN       0                     // move wheel one step
+#define TASK_KEYTIMER   1                     // button driver timer
+#define TASK_KEY        2                     // evaluate button events
+#define TASK_OFF        3                     // auto-off after inactivity
+
+// Global variables
+uint8_t number;                               // current LED number
+uint8_t speed;                                // current delay between steps in ms
+uint8_t hue;                                  // current hue
+uint8_t spin;                                 // 1: wheel is spinning
+PT_t    wheel;                                // state of wheel protothread
+#if PT_PROFILE > 0
+uint32_t ptcost;                              // ticks per context switch (debugger)
+#endif
+
+// Move wheel one step
+void WOF_step(void) {
+  if(++hue > 191) hue = 0;                    // next hue value
+  if(++number >= NEO_COUNT) number = 0;       // next pixel number
+  NEO_setPixel(number, hue);                  // set next pixel
+}
+
+// Wheel protothread: wait for key press, speed up, slow down, stop
+PT_THREAD(WOF_wheel(PT_t *pt)) {
+  PT_BEGIN(pt);
+  while(1) {
+    PT_WAIT_UNTIL(pt, spin);                  // wait for key press
+    PT_SYNC(pt);                              // first step right away
+    while(--speed) {                          // speed up
+      WOF_step();
+      PT_SLEEP(pt, TASK_SPIN, SCHED_MS(speed));
+    }
+    for(speed=1; speed<96; speed++) {         // slow down
+      WOF_step();
+      PT_SLEEP(pt, TASK_SPIN, SCHED_MS(speed));
+    }
+    spin = 0;                                 // wheel stopped: accept next key press
+    #if AUTO_OFF > 0
+    SCHED_in(TASK_OFF, SCHED_MS((uint32_t)AUTO_OFF * 1000));
+    #endif
+  }
+  PT_END(pt);
+}
+
+// Run wheel protothread (scheduler task)
+void WOF_spin(void) {
+  WOF_wheel(&wheel);
+}
+
+// Start spinning the wheel on key press (signaled by button driver)
+void WOF_key(void) {
+  uint8_t event;
+  while((event = KEY_get()) != KEY_NONE) {
+    if(spin || (event != KEY_PRESS)) continue;    // ignore key while spinning
+    LAT_record(LAT_DECIDE, KEY_time());       // button edge to decision latency
+    LAT_start(LAT_FRAME, KEY_time());
+    SCHED_stop(TASK_OFF);                     // no auto-off while spinning
+    speed = 16 + (STK->CNT & 15);             // set start speed randomly
+    spin  = 1;
+    SCHED_signal(TASK_SPIN);                  // wake up wheel protothread
+  }
+}
+
+// Turn off all pixels and go to standby until the button is pressed
+void WOF_off(void) {
+  NEO_setPixel(NEO_COUNT, 0);                 // blank all LEDs
+  KEY_sleep(PWR_KEEP(PIN_NEO));               // standby until button pressed
+  NEO_setPixel(number, hue);                  // show wheel right away
 }
 
 // ===================================================================================
 // Main Function
 // ===================================================================================
 int main(void) {
-  // Local variables
-  uint8_t number = 0;                         // current LED number
-  uint8_t speed;                              // current speed of wheel
-  uint8_t hue = 0;                            // current hue
-
   // Setup
-  PIN_input_PU(PIN_KEY);                      // set button pin to input pullup
-  PIN_EVT_set(PIN_KEY, PIN_EVT_FALLING);      // set pin change event for button pin
+  number = 0; hue = 0; spin = 0;             // start with first pixel
+  PT_init(&wheel);                            // init wheel protothread
+  #if PT_PROFILE > 0
+  ptcost = PT_measure();                      // measure context switch cost
+  #endif
   NEO_init();                                 // init Neopixels
   NEO_setPixel(number, hue);                  // set start pixel
+  SCHED_init();                               // init scheduler
+  LAT_init();                                 // init latency statistics
+  KEY_init(TASK_KEYTIMER, TASK_KEY);          // init button driver
+  SCHED_set(TASK_SPIN, WOF_spin);             // attach wheel tasks
+  SCHED_set(TASK_KEY, WOF_key);
+  SCHED_set(TASK_OFF, WOF_off);
+  #if AUTO_OFF > 0
+  SCHED_in(TASK_OFF, SCHED_MS((uint32_t)AUTO_OFF * 1000));
+  #endif
 
   // Loop
-  while(1) {    
-    SLEEP_WFE_now();                          // put MCU to sleep, wake up by event
-    if(!PIN_read(PIN_KEY)) {                  // if button pressed:
-      speed = 16 + (STK->CNT & 15);           // set start speed randomly
-      while(--speed) {                        // increase speed
-        if(++hue > 191) hue = 0;              // next hue value
-        if(++number >= NEO_COUNT) number = 0; // next pixel number
-        NEO_setPixel(number, hue);            // set next pixel
-        DLY_ms(speed);                        // delay
-      }
-      while(++speed < 96) {
-        if(++hue > 191) hue = 0;              // next hue value
-        if(++number >= NEO_COUNT) number = 0; // next pixel number
-        NEO_setPixel(number, hue);            // set next pixel
-        DLY_ms(speed);                        // delay
-      }
-      while(!PIN_read(PIN_KEY));              // wait for button released
-      DLY_ms(10);                             // debounce
-    }
-  }
+  while(1) SCHED_run();                       // run tasks, sleep in between
 }
@@ -0,0 +1,125 @@
+// ===================================================================================
+// Protothreads (Stackless Coroutines) for CH32V003                           * v1.0 *
+// ===================================================================================
+//
+// Lets a scheduler task be written as sequential code with waits, without a stack
+// per task. A protothread is a function that returns whenever it has to wait and
+// continues at the same line the next time it is called. The resume point is kept
+// in a 16-bit local continuation (the source line number of the last wait, used as
+// case label of a switch statement). Together with the 32-bit reference time of
+// PT_SLEEP(), the state of a thread needs 8 bytes of RAM (2 bytes are padding).
+// PT_SLEEP() hooks the thread into the scheduler (sched.h): the task function calls
+// the protothread, the scheduler runs the task again when the sleep time is over.
+//
+// Functions available:
+// --------------------
+// PT_init(pt)              init protothread state (start at the beginning)
+// PT_THREAD(func(pt))      declare protothread function
+// PT_BEGIN(pt)             start of protothread body
+// PT_END(pt)               end of protothread body (thread ends, restarts on next call)
+// PT_WAIT_UNTIL(pt, cond)  wait until condition is true (checked on every call)
+// PT_YIELD(pt)             return to scheduler once
+// PT_EXIT(pt)              end thread right away
+// PT_SYNC(pt)              set reference time of PT_SLEEP() to now
+// PT_SLEEP(pt, task, n)    wait n SysTick ticks after the last wake-up time of the
+//                          thread (drift-free), task: scheduler slot of the thread
+// PT_measure()             SysTick ticks of one resume and wait (with PT_PROFILE)
+//
+// Notes:
+// ------
+// - Local variables are not kept across waits. Use static or global variables.
+// - switch statements cannot be used around a wait inside the thread body.
+// - Waits can only be placed in the protothread function itself, not in functions
+//   it calls.
+// - Context switch cost: a wait stores the line number and returns (3 instructions),
+//   a resume loads it and jumps through the switch table (about 8 instructions),
+//   plus the call of the protothread from the task function. That is roughly 20
+//   cycles per switch at -Os, compared to several hundred bytes of RAM per task for
+//   a stack based scheduler. To measure it, set PT_PROFILE to 1: PT_measure() calls
+//   a thread that resumes and yields right away PT_RUNS times and returns the
+//   SysTick ticks per call without the loop (1 tick = 1 cycle at 8MHz). neo_wof
+//   stores the result in ptcost at start-up (debugger read-out).
+//
+// References:
+// -----------
+// - Adam Dunkels, Protothreads: http://dunkels.com/adam/pt/
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "system.h"
+#include "sched.h"
+
+// ===================================================================================
+// Protothread Settings
+// ===================================================================================
+#define PT_PROFILE        0                   // 1: enable PT_measure()
+#define PT_RUNS           64                  // calls averaged by PT_measure()
+
+// ===================================================================================
+// Protothread Functions
+// ===================================================================================
+typedef struct {
+  uint16_t lc;                                // local continuation (resume line)
+  uint32_t wake;                              // reference time of PT_SLEEP()
+} PT_t;
+
+enum{PT_WAITING, PT_ENDED};
+
+#define PT_THREAD(func)   uint8_t func
+#define PT_init(pt)       (pt)->lc = 0
+
+#define PT_BEGIN(pt)      switch((pt)->lc) { case 0:
+#define PT_END(pt)        } (pt)->lc = 0; return PT_ENDED
+
+#define PT_WAIT_UNTIL(pt, cond) \
+  do { (pt)->lc = __LINE__; case __LINE__: if(!(cond)) return PT_WAITING; } while(0)
+
+#define PT_YIELD(pt) \
+  do { (pt)->lc = __LINE__; return PT_WAITING; case __LINE__: ; } while(0)
+
+#define PT_EXIT(pt) \
+  do { (pt)->lc = 0; return PT_ENDED; } while(0)
+
+#define PT_SYNC(pt)       (pt)->wake = STK->CNT
+
+#define PT_SLEEP(pt, task, n) \
+  do { (pt)->wake += (n); SCHED_at(task, (pt)->wake); \
+       PT_WAIT_UNTIL(pt, (int32_t)(STK->CNT - (pt)->wake) >= 0); } while(0)
+
+// ===================================================================================
+// Context Switch Measurement
+// ===================================================================================
+#if PT_PROFILE > 0
+// Thread that yields on every call
+static __attribute__((noinline)) PT_THREAD(PT_yielder(PT_t *pt)) {
+  PT_BEGIN(pt);
+  while(1) PT_YIELD(pt);
+  PT_END(pt);
+}
+
+// Measure SysTick ticks of one call (resume and wait) of a protothread
+static inline uint32_t PT_measure(void) {
+  static PT_t pt;
+  uint32_t start, loop, runs;
+  uint8_t  i;
+  PT_init(&pt);
+  PT_yielder(&pt);                            // run to the first wait
+  start = STK->CNT;                           // loop and SysTick read only
+  for(i=0; i<PT_RUNS; i++) __asm volatile("");
+  loop  = STK->CNT - start;
+  start = STK->CNT;                           // loop with context switches
+  for(i=0; i<PT_RUNS; i++) PT_yielder(&pt);
+  runs  = STK->CNT - start;
+  return (runs - loop) / PT_RUNS;
+}
+#endif
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,166 @@
+// ===================================================================================
+// Tickless Event-Driven Scheduler for CH32V003                               * v1.0 *
+// ===================================================================================
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#include "sched.h"
+
+// Task table
+static SCHED_func_t      SCHED_func[SCHED_TASKS];       // task functions
+static uint32_t          SCHED_due[SCHED_TASKS];        // SysTick due times
+static uint8_t           SCHED_timer;                   // bitmap of running timers
+static volatile uint8_t  SCHED_pending;                 // bitmap of signaled tasks
+static uint32_t          SCHED_woken;                   // time of last wake-up
+#if SCHED_STDBY > 0
+static uint32_t          SCHED_pins;                    // pins kept in standby
+#endif
+
+// ===================================================================================
+// Task Functions
+// ===================================================================================
+
+// Init scheduler
+void SCHED_init(void) {
+  SCHED_timer   = 0;
+  SCHED_pending = 0;
+  SCHED_woken   = 0;                                    // no wake-up yet
+  ALM_init();                                           // SysTick compare wake-up
+  #if SCHED_STDBY > 0
+  SCHED_pins    = 0xFFFFFF;                             // keep all pins by default
+  AWU_init();                                           // start LSI and AWU event
+  AWU_disable();
+  #endif
+  INT_enable();
+}
+
+// Attach task function to task slot
+void SCHED_set(uint8_t id, SCHED_func_t func) {
+  SCHED_func[id] = func;
+}
+
+// Run task at SysTick time
+void SCHED_at(uint8_t id, uint32_t time) {
+  SCHED_due[id] = time;
+  SCHED_timer  |= 1 << id;
+}
+
+// Run task in ticks from now
+void SCHED_in(uint8_t id, uint32_t ticks) {
+  SCHED_at(id, STK->CNT + ticks);
+}
+
+// Run task ticks after its last due time (drift-free periodic task)
+void SCHED_next(uint8_t id, uint32_t ticks) {
+  SCHED_at(id, SCHED_due[id] + ticks);
+}
+
+// Stop task timer
+void SCHED_stop(uint8_t id) {
+  SCHED_timer &= ~(1 << id);
+}
+
+// Request task to run as soon as possible (can be called from interrupt)
+void SCHED_signal(uint8_t id) {
+  INT_ATOMIC_BLOCK { SCHED_pending |= 1 << id; }
+}
+
+// Set pins that keep their configuration in standby
+void SCHED_keep(uint32_t mask) {
+  #if SCHED_STDBY > 0
+  SCHED_pins = mask;
+  #endif
+}
+
+// ===================================================================================
+// Idle Functions
+// ===================================================================================
+
+#if SCHED_STDBY > 0
+#define SCHED_AWU_BIT     ((uint32_t)1 << 9)            // EXTI line of AWU
+#define SCHED_PIN_BITS    0xFF                          // EXTI lines of pins
+#define SCHED_AWU_MAX_MS  30719                         // longest period AWU_set() takes
+
+// Put device into standby for up to ms milliseconds (ms < 30720) and advance the time
+// base afterwards by the period the AWU was really set to
+static void SCHED_standby(uint32_t ms) {
+  uint32_t events = EXTI->EVENR;
+  AWU_disable();                                        // restart AWU counter
+  AWU_set(ms);                                          // set wake-up period
+  EXTI->INTFR = SCHED_AWU_BIT;                          // clear AWU flag
+  EXTI->EVENR = events | (EXTI->INTENR & SCHED_PIN_BITS); // pin interrupts wake up
+  AWU_enable();
+  PWR_save(SCHED_pins);                                 // unused pins to analog input
+  STDBY_WFE_now();                                      // wake up by AWU or pin edge
+  PWR_restore();
+  AWU_disable();
+  EXTI->EVENR = events;
+  if(EXTI->INTFR & SCHED_AWU_BIT) {                     // woken by AWU: advance time
+    EXTI->INTFR = SCHED_AWU_BIT;
+    STK->CNT   += SCHED_MS(AWU_period(ms));             // period AWU really ran
+  }
+  INT_enable();                                         // let pending interrupts in
+  INT_disable();
+}
+#endif
+
+// ===================================================================================
+// Scheduler Main Function
+// ===================================================================================
+
+// Run all due tasks, sleep until next event if there is nothing to do
+void SCHED_run(void) {
+  uint8_t  i, bit, ran = 0;
+  uint8_t  next  = 0;
+  int32_t  wait, first = 0;
+
+  // Run signaled and due tasks
+  for(i=0, bit=1; i<SCHED_TASKS; i++, bit<<=1) {
+    if(SCHED_pending & bit) {
+      INT_ATOMIC_BLOCK { SCHED_pending &= ~bit; }
+      SCHED_func[i]();
+      ran = 1;
+    }
+    else if((SCHED_timer & bit) && ((int32_t)(STK->CNT - SCHED_due[i]) >= 0)) {
+      SCHED_timer &= ~bit;
+      SCHED_func[i]();
+      ran = 1;
+    }
+  }
+  if(ran) return;
+
+  // Find next due task
+  for(i=0, bit=1; i<SCHED_TASKS; i++, bit<<=1) {
+    if(!(SCHED_timer & bit)) continue;
+    wait = SCHED_due[i] - STK->CNT;
+    if(!next || (wait < first)) {
+      first = wait;
+      next  = i + 1;
+    }
+  }
+
+  // Sleep until next task is due or an interrupt occurs
+  INT_disable();
+  if(!SCHED_pending) {
+    if(!next) SLEEP_WFI_now();                          // no timer: wait for interrupt
+    #if SCHED_STDBY > 0
+    else if(first >= (int32_t)SCHED_MS(SCHED_STDBY_MS)) {
+      first /= DLY_MS_TIME;                             // longer waits in several parts
+      SCHED_standby(first > SCHED_AWU_MAX_MS ? SCHED_AWU_MAX_MS : first);
+    }
+    #endif
+    else if(first > 0) ALM_sleep(SCHED_due[next - 1]);  // SysTick runs in sleep
+    SCHED_woken = STK->CNT;                             // before any ISR runs
+  }
+  INT_enable();
+}
+
+// Get SysTick time of last wake-up
+uint32_t SCHED_wakeTime(void) {
+  return SCHED_woken;
+}
+
+// Set wake-up time to now (device was woken up outside of SCHED_run)
+void SCHED_woke(void) {
+  SCHED_woken = STK->CNT;
+}
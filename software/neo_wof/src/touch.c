@@ -0,0 +1,67 @@
+// ===================================================================================
+// Capacitive Touch Sensor for CH32V003                                       * v1.0 *
+// ===================================================================================
+//
+// 2024 by Stefan Wagner:   https://github.com/wagiminator
+
+#include "touch.h"
+
+// Sensor state
+volatile uint16_t TOUCH_ticks;                          // duration of last scan
+static uint32_t   TOUCH_base;                           // baseline << TOUCH_DRIFT
+static uint8_t    TOUCH_state;                          // 1: touched
+static uint8_t    TOUCH_held;                           // scans since touch
+
+// Scan touch pad, return sum of TOUCH_SAMPLES conversions (lower: touched)
+uint16_t TOUCH_read(void) {
+  uint16_t sum   = 0;
+  uint32_t start = STK->CNT;
+  uint32_t smp   = ADC1->SAMPTR2;                       // save sampling time
+  ADC_enable();                                         // power up ADC
+  DLY_us(10);                                           // wait to settle
+  ADC_fast();                                           // short charge sharing
+  for(uint8_t i=TOUCH_SAMPLES; i; i--) {
+    PIN_low(TOUCH_PIN);                                 // discharge pad
+    PIN_output(TOUCH_PIN);
+    ADC_input_VREF();                                   // charge sample capacitor
+    ADC_read();
+    PIN_input_AN(TOUCH_PIN);                            // pad floating
+    ADC_input(TOUCH_PIN);                               // share charge with pad
+    sum += ADC_read();
+  }
+  ADC_disable();                                        // power down ADC
+  ADC1->SAMPTR2 = smp;                                  // restore sampling time
+  TOUCH_ticks   = STK->CNT - start;
+  return sum;
+}
+
+// Scan touch pad, track baseline and return touch state
+uint8_t TOUCH_sense(void) {
+  uint16_t raw  = TOUCH_read();
+  uint16_t base = TOUCH_base >> TOUCH_DRIFT;
+  int16_t  drop = (int16_t)(base - raw);
+  if(TOUCH_state) {
+    if(drop < TOUCH_THRESHOLD - TOUCH_HYST) TOUCH_state = 0;  // released
+    else if(++TOUCH_held == TOUCH_STUCK) {                    // touched for too long?
+      TOUCH_base  = (uint32_t)raw << TOUCH_DRIFT;             // -> recalibrate
+      TOUCH_state = 0;
+    }
+  }
+  else if(drop >= TOUCH_THRESHOLD) {                          // touched
+    TOUCH_state = 1;
+    TOUCH_held  = 0;
+  }
+  if(!TOUCH_state) TOUCH_base += raw - base;                  // track baseline
+  return TOUCH_state;
+}
+
+// Init ADC and pin, calibrate baseline (pad must not be touched)
+void TOUCH_init(void) {
+  uint32_t sum = 0;
+  ADC_init();                                           // init and calibrate ADC
+  ADC_disable();                                        // only powered while scanning
+  PIN_input_AN(TOUCH_PIN);
+  for(uint8_t i=1<<TOUCH_DRIFT; i; i--) sum += TOUCH_read();
+  TOUCH_base  = sum;                                    // average << TOUCH_DRIFT
+  TOUCH_state = 0;
+}
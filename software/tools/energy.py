@@ -0,0 +1,314 @@
+#!/usr/bin/env python3
+# ===================================================================================
+# Project:   TinyBling - Energy Model and Battery Life Estimator
+# Version:   v1.0
+# Year:      2024
+# Author:    Stefan Wagner
+# Github:    https://github.com/wagiminator
+# License:   http://creativecommons.org/licenses/by-sa/3.0/
+# ===================================================================================
+#
+# Description:
+# ------------
+# Estimates the average supply current and the expected LIR2032 runtime of each
+# neo_demo animation and of each firmware. Three inputs are combined:
+# - active CPU cycles per wake-up (defaults are instruction count estimates, replace
+#   them with measured values using --cycles); animations that neo_demo computes
+#   with the fast clock (fire) run their calculation at 48MHz, NEO_show at 8MHz,
+# - LED current, calculated from the channel values of every simulated frame (the
+#   neo_demo animations and NEO_show are replicated here 1:1, including the skipped
+#   transmission of repeated black frames and the doubled frame period after
+#   NEO_DARK black frames; the animation itself is calculated in every frame),
+# - datasheet currents of the MCU in run, sleep and standby mode.
+#
+# All electrical parameters are typical values and can be overridden on the
+# command line, see --help.
+#
+# Usage:
+# ------
+# python3 energy.py
+# python3 energy.py --refresh 32 --cycles fire=12000 --capacity 35
+
+import argparse
+import math
+
+# ===================================================================================
+# Default Parameters
+# ===================================================================================
+F_CPU          = 8000000      # CPU frequency in Hz
+NEO_COUNT      = 16           # number of NeoPixels
+NEO_REFRESH    = 64           # neo_demo refresh period in ms
+NEO_AUTO_COUNT = 76           # frames per animation in auto mode
+NEO_DARK       = 8            # black frames until refresh period is doubled
+NEO_DIM        = 0            # global brightness reduction (0..3, long press)
+
+F_FAST         = 48000000     # CPU frequency of the fast animations in Hz
+I_RUN          = 1.6          # mA, MCU run mode at 8MHz (HSI), typical
+I_FAST         = 4.2          # mA, MCU run mode at 48MHz (HSI with PLL), estimate
+I_SLEEP        = 0.9          # mA, MCU sleep mode at 8MHz, typical
+I_STDBY        = 0.010        # mA, MCU standby with LSI and AWU, typical
+I_LED_CH       = 5.0          # mA, WS2812C-2020 channel current at value 255
+I_LED_IDLE     = 0.3          # mA, WS2812C-2020 quiescent current per LED
+CAPACITY       = 40.0         # mAh, LIR2032 nominal capacity
+WAKE_US        = 20           # us, standby wake-up time (HSI start-up)
+PLL_US         = 30           # us, PLL lock and clock switch (at 8MHz), estimate
+
+# Estimated active cycles per frame: NEO_show ~300 cycles per pixel plus the
+# animation itself (derived from the instruction count at -Os, not measured). For
+# FAST_ANIMS the animation part runs at 48MHz. Replace 'comets' and 'fire' with the
+# partcost/firecost values read out of a neo_demo built with ANIM_PROFILE 1.
+SHOW_CYCLES    = 300 * NEO_COUNT
+FAST_ANIMS     = ['fire']
+BLACK_CYCLES   = 8 * NEO_COUNT  # NEO_isBlack() scan instead of a transmission
+ANIM_CYCLES    = {
+  'chase':   SHOW_CYCLES +  400,
+  'sparkle': SHOW_CYCLES +  900,
+  'random':  SHOW_CYCLES + 2500,
+  'rainbow': SHOW_CYCLES +   50,
+  'fill':    SHOW_CYCLES +  200,
+  'wave':    SHOW_CYCLES +  600,
+  'comets':  SHOW_CYCLES + 1200,
+  'fire':    SHOW_CYCLES + 3500,
+}
+
+# ===================================================================================
+# neo_demo Replica
+# ===================================================================================
+NEO_gamma = [
+    0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   3,   4,   5,
+    6,   7,   8,  10,  11,  13,  14,  16,  18,  20,  22,  25,  27,  30,  33,  36,
+   39,  43,  47,  50,  55,  59,  63,  68,  73,  78,  83,  89,  95, 101, 107, 114,
+  120, 127, 135, 142, 150, 158, 167, 175, 184, 193, 203, 213, 223, 233, 244, 255
+]
+
+# Replica of sin8() from wave.h
+def sin8(theta):
+  idx = theta & 63
+  if theta & 64: idx = 64 - idx
+  val = round(32767 * math.sin(idx * math.pi / 128)) >> 8
+  return 128 - val if theta & 128 else 128 + val
+
+class Demo:
+  def __init__(self):
+    self.hue    = [0] * NEO_COUNT
+    self.bright = [0] * NEO_COUNT
+    self.heat   = [0] * NEO_COUNT
+    self.parts  = []
+    self.rnval  = 0xDEADBEEF
+
+  def prng(self, maxval):
+    r = self.rnval
+    r = ((r << 16) | (((r << 1) ^ (r << 2)) & 0xFFFFFFFF) >> 16) & 0xFFFFFFFF
+    self.rnval = r
+    return r % maxval
+
+  # Check if NEO_show would skip the frame (all pixels too dark, NEO_isBlack)
+  def is_black(self):
+    return all(b <= NEO_DIM + 2 for b in self.bright)
+
+  # Sum of all channel values that NEO_show would transmit
+  def channels(self):
+    total = 0
+    for i in range(NEO_COUNT):
+      shift = min(6, 6 - self.bright[i] + NEO_DIM)
+      step  = self.hue[i] & 63
+      if self.hue[i] >> 6 < 3:
+        total += NEO_gamma[step >> shift] + NEO_gamma[(63 - step) >> shift]
+    return total
+
+  def set(self, i, hue):
+    self.bright[i] = 6
+    self.hue[i] = hue
+
+  def add(self, i, hue, bright):
+    if bright > self.bright[i]: self.hue[i] = hue
+    self.bright[i] = min(6, self.bright[i] + bright)
+
+  def fade_out(self):
+    self.bright = [max(0, b - 1) for b in self.bright]
+
+  # Animations (one generator per neo_demo state, yields once per frame)
+  def chase(self):
+    hue1, hue2, ptr1, ptr2 = 0, 96, 0, NEO_COUNT >> 1
+    while True:
+      self.fade_out()
+      hue1 += 4; hue2 += 4
+      if hue1 > 191: hue1 -= 192
+      if hue2 > 191: hue2 -= 192
+      ptr1 = (ptr1 + 1) % NEO_COUNT; ptr2 = (ptr2 + 1) % NEO_COUNT
+      self.set(ptr1, hue1); self.set(ptr2, hue2)
+      yield
+
+  def sparkle(self):
+    while True:
+      self.fade_out()
+      for _ in range(self.prng(4)):
+        self.set(self.prng(NEO_COUNT), self.prng(192))
+      yield
+
+  def random(self):
+    for i in range(NEO_COUNT): self.set(i, self.prng(192))
+    yield
+    while True:
+      for i in range(NEO_COUNT):
+        self.hue[i] = (self.hue[i] + self.prng(8)) & 0xFF
+        if self.hue[i] > 191: self.hue[i] -= 192
+      yield
+
+  def rainbow(self):
+    for i in range(NEO_COUNT): self.set(i, i * (192 // NEO_COUNT))
+    while True:
+      yield                                   # rotation keeps the channel sum
+
+  def fill(self):
+    hue = 0
+    self.bright = [6] * NEO_COUNT
+    while True:
+      hue += 3
+      if hue > 191: hue -= 192
+      self.hue = [hue] * NEO_COUNT
+      yield
+
+  def wave(self):
+    hue, phase = 0, 0
+    while True:
+      hue = (hue + 1) % 192
+      phase = (phase + 8) & 0xFF
+      for i in range(NEO_COUNT):
+        ph = (phase + i * (256 // NEO_COUNT)) & 0xFF
+        s = sin8(ph)
+        self.hue[i] = hue
+        self.bright[i] = (s * 7) >> 8
+      yield
+
+  def comets(self):
+    while True:
+      self.fade_out(); self.fade_out()
+      if not self.prng(6) and len(self.parts) < 8:
+        vel = 0x60 if self.prng(2) else -0x60
+        self.parts.append([self.prng(NEO_COUNT) << 8, vel, self.prng(192), 255, 3])
+      if not self.prng(3) and len(self.parts) < 8:
+        self.parts.append([self.prng(NEO_COUNT) << 8, 0, self.prng(192), 255, 48])
+      alive = []
+      for p in self.parts:
+        if p[3] > p[4]:
+          p[3] -= p[4]
+          p[0] = (p[0] + p[1]) % (NEO_COUNT << 8)
+          alive.append(p)
+      self.parts = alive
+      for p in self.parts:
+        self.add(p[0] >> 8, p[2], (p[3] >> 5) + 1)
+      yield
+
+  def fire(self):
+    while True:
+      h = self.heat
+      for i in range(NEO_COUNT):
+        h[i] = max(0, h[i] - self.prng(24))
+      first, prev = h[0], h[-1]
+      for i in range(NEO_COUNT):
+        cur = h[i]
+        h[i] = (prev + (cur << 1) + (h[i + 1] if i < NEO_COUNT - 1 else first)) >> 2
+        prev = cur
+      if self.prng(256) < 160:
+        i = self.prng(NEO_COUNT)
+        h[i] = min(255, h[i] + 160 + self.prng(96))
+      for i in range(NEO_COUNT):
+        self.hue[i] = h[i] >> 3
+        self.bright[i] = 6 if h[i] > 191 else h[i] >> 5
+      yield
+
+ANIMATIONS = ['chase', 'sparkle', 'random', 'rainbow', 'fill', 'wave', 'comets', 'fire']
+
+# ===================================================================================
+# Energy Model
+# ===================================================================================
+def led_current(channel_sum, leds_on=NEO_COUNT):
+  return channel_sum / 255 * I_LED_CH + leds_on * I_LED_IDLE
+
+# MCU charge in mAs of one frame period with the given active cycles of the
+# animation and of NEO_show
+def frame_charge(name, anim, show, t_frame):
+  t_slow = show / F_CPU + WAKE_US / 1e6
+  if name in FAST_ANIMS:                      # PLL start at 8MHz, animation fast
+    t_slow += PLL_US / 1e6
+    t_fast  = anim / F_FAST
+  else:
+    t_slow += anim / F_CPU
+    t_fast  = 0
+  q_run = I_RUN * t_slow + I_FAST * t_fast
+  return q_run + I_STDBY * (t_frame - t_slow - t_fast)
+
+# Average MCU and LED current of an animation and its duration in auto mode
+def demo_current(name, cycles):
+  demo  = Demo()
+  anim  = getattr(demo, name)()
+  black, dark = False, 0                      # NEO_black, dark of ANIM_frame
+  q_mcu, q_led, t_total = 0, 0, 0
+  for _ in range(NEO_AUTO_COUNT):
+    t_frame = NEO_REFRESH / 1000 * (2 if dark >= NEO_DARK else 1)
+    next(anim)
+    if demo.is_black():                       # repeated black frame: calculated, not sent
+      skip, black = black, True
+    else:
+      skip, black = False, False
+    show    = BLACK_CYCLES if skip else SHOW_CYCLES   # animation runs anyway
+    q_mcu  += frame_charge(name, cycles - SHOW_CYCLES, show, t_frame)
+    q_led  += led_current(demo.channels()) * t_frame
+    t_total += t_frame
+    dark = min(dark + 1, NEO_DARK) if black else 0
+  return q_mcu / t_total, q_led / t_total, t_total
+
+def report(name, i_mcu, i_led):
+  i_avg = i_mcu + i_led
+  print('%-14s %8.3f %8.3f %8.3f %8.1f' % (name, i_mcu, i_led, i_avg, CAPACITY / i_avg))
+
+def main():
+  global NEO_REFRESH, NEO_DIM, CAPACITY, I_RUN, I_FAST, I_SLEEP, I_STDBY, I_LED_CH, I_LED_IDLE
+  parser = argparse.ArgumentParser(description='TinyBling energy model')
+  parser.add_argument('--refresh',  type=int,   default=NEO_REFRESH, help='NEO_REFRESH in ms')
+  parser.add_argument('--dim',      type=int,   default=NEO_DIM,     help='NEO_dim (0..3)')
+  parser.add_argument('--capacity', type=float, default=CAPACITY,    help='battery capacity in mAh')
+  parser.add_argument('--i-run',    type=float, default=I_RUN,       help='MCU run current in mA')
+  parser.add_argument('--i-fast',   type=float, default=I_FAST,      help='MCU run current at 48MHz in mA')
+  parser.add_argument('--i-sleep',  type=float, default=I_SLEEP,     help='MCU sleep current in mA')
+  parser.add_argument('--i-stdby',  type=float, default=I_STDBY,     help='MCU standby current in mA')
+  parser.add_argument('--i-led',    type=float, default=I_LED_CH,    help='LED channel current in mA')
+  parser.add_argument('--i-idle',   type=float, default=I_LED_IDLE,  help='LED quiescent current in mA')
+  parser.add_argument('--cycles',   action='append', default=[],
+                      metavar='ANIM=N', help='measured active cycles per frame')
+  args = parser.parse_args()
+
+  NEO_REFRESH, NEO_DIM, CAPACITY = args.refresh, args.dim, args.capacity
+  I_RUN, I_FAST, I_SLEEP, I_STDBY = args.i_run, args.i_fast, args.i_sleep, args.i_stdby
+  I_LED_CH, I_LED_IDLE = args.i_led, args.i_idle
+  for item in args.cycles:
+    name, value = item.split('=')
+    ANIM_CYCLES[name] = int(value)
+
+  print('%-14s %8s %8s %8s %8s' % ('', 'MCU mA', 'LED mA', 'avg mA', 'hours'))
+  print('neo_demo (refresh %d ms, dim %d):' % (NEO_REFRESH, NEO_DIM))
+  sum_mcu, sum_led, sum_t = 0, 0, 0
+  for name in ANIMATIONS:                     # auto mode: weighted by duration
+    i_mcu, i_led, t = demo_current(name, ANIM_CYCLES[name])
+    report('  ' + name, i_mcu, i_led)
+    sum_mcu += i_mcu * t
+    sum_led += i_led * t
+    sum_t   += t
+  report('  auto mode', sum_mcu / sum_t, sum_led / sum_t)
+
+  # Auto-off: MCU in standby (AWU off, button event only), LEDs black but powered
+  report('  auto-off', I_STDBY, led_current(0))
+
+  # neo_hunt: CPU sleeps between hunter steps and key presses (SLEEP_WFI, SysTick
+  # compare and pin interrupt), one green and one red pixel at 0x3f
+  print('neo_hunt:')
+  report('  playing', I_SLEEP, led_current(2 * 0x3f))
+
+  # neo_wof: CPU sleeps (SLEEP_WFE), one pixel with channel sum 252
+  print('neo_wof:')
+  report('  idle', I_SLEEP, led_current(252))
+  report('  auto-off', I_STDBY, led_current(0))
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,405 @@
+// ===================================================================================
+// Project:   TinyBling - Host Latency Simulation of the Hunting Game
+// Version:   v1.0
+// Year:      2024
+// Author:    Stefan Wagner
+// Github:    https://github.com/wagiminator
+// License:   http://creativecommons.org/licenses/by-sa/3.0/
+// ===================================================================================
+//
+// Description:
+// ------------
+// Builds neo_hunt's main.c, key.c, sched.c and lat.c with the native compiler and
+// plays the game with scripted button edges. SysTick, EXTI, GPIO and the interrupt
+// controller are replaced by a simulation with its own time base. The button is
+// pressed by a simulated player who aims at the deer, presses a step too early,
+// bounces, holds the button for a long press, double-clicks, presses a few us after
+// the hunter reached the deer or before it leaves (judged by the edge timestamp
+// against the step boundary) and presses during the blue reset flash. The latency recorder (lat.c) collects the same statistics as on
+// the target. The exit code is 1 if any channel exceeds its limit (LAT_LIMIT_* in
+// lat.h) or if a catch is judged wrong.
+//
+// Timing model: a NeoPixel byte takes 80 ticks (10us at 8MHz), an interrupt entry
+// SIM_ISR_TICKS, each SysTick access SIM_STK_TICKS and the wake-up from sleep
+// SIM_WAKE_TICKS, all other code takes no time. The simulation therefore checks what
+// lies between a button edge and the decision or frame (tasks, latch waits, frames,
+// sleeps), it is not cycle-accurate.
+//
+// Usage:
+// ------
+// make -C software/tools test
+// build/hunt_sim [presses]
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// ===================================================================================
+// Simulated Peripherals (replace the register blocks before the firmware is parsed)
+// ===================================================================================
+#define interrupt         used                  // no interrupt attribute on the host
+#include "../neo_hunt/src/ch32v003.h"
+
+#define SIM_STK_TICKS     2                     // ticks per SysTick access
+#define SIM_ISR_TICKS     16                    // ticks of interrupt entry
+#define SIM_WAKE_TICKS    8                     // ticks of wake-up from sleep
+#define SIM_BYTE_TICKS    80                    // ticks per NeoPixel byte
+
+static STK_TypeDef  SIM_stk;
+static EXTI_TypeDef SIM_exti;
+static GPIO_TypeDef SIM_gpio[3];
+static AFIO_TypeDef SIM_afio;
+static RCC_TypeDef  SIM_rcc;
+static PFIC_TypeDef SIM_pfic;
+static STK_TypeDef *SIM_stkAccess(void);
+static EXTI_TypeDef *SIM_extiAccess(void);
+
+#undef  STK
+#undef  EXTI
+#undef  GPIOA
+#undef  GPIOC
+#undef  GPIOD
+#undef  AFIO
+#undef  RCC
+#undef  PFIC
+#define STK               (SIM_stkAccess())
+#define EXTI              (SIM_extiAccess())
+#define GPIOA             (&SIM_gpio[0])
+#define GPIOC             (&SIM_gpio[1])
+#define GPIOD             (&SIM_gpio[2])
+#define AFIO              (&SIM_afio)
+#define RCC               (&SIM_rcc)
+#define PFIC              (&SIM_pfic)
+
+#include "../neo_hunt/config.h"
+#include "../neo_hunt/src/system.h"
+#include "../neo_hunt/src/gpio.h"
+#include "../neo_hunt/src/sched.h"
+#include "../neo_hunt/src/key.h"
+#include "../neo_hunt/src/lat.h"
+
+// Interrupt enable (MIE) of the simulated core
+static uint32_t SIM_save(void);
+static void     SIM_restore(const uint32_t *save);
+static void     SIM_intEnable(void);
+static uint8_t  SIM_mie = 1;                    // enabled by mret in reset_handler
+
+#undef  INT_enable
+#undef  INT_disable
+#undef  INT_ATOMIC_BLOCK
+#define INT_enable()      SIM_intEnable()
+#define INT_disable()     (SIM_mie = 0)
+#define INT_ATOMIC_BLOCK  for(uint32_t __save __attribute__((__cleanup__(SIM_restore))) \
+                              = SIM_save(), __ToDo = 1; __ToDo; __ToDo = 0)
+
+// ===================================================================================
+// Firmware
+// ===================================================================================
+static void SIM_sendByte(void);
+
+#include "../neo_hunt/src/sched.c"
+#include "../neo_hunt/src/key.c"
+#include "../neo_hunt/src/lat.c"
+
+// NeoPixel output is RISC-V assembly: its asm statement is replaced by the model of
+// the transmission time (these keyword macros are only active for main.c)
+#define asm               SIM_sendByte()
+#define volatile(...)
+#define main              HUNT_main
+#include "../neo_hunt/src/main.c"
+#undef  asm
+#undef  volatile
+#undef  main
+
+// ===================================================================================
+// Simulation Time and Button Edges
+// ===================================================================================
+#define SIM_EDGES         16                    // edge queue size
+#define SIM_after(a, b)   ((int32_t)((a) - (b)) >= 0)
+
+static uint32_t SIM_now = 1000;                 // SysTick time (boot takes a bit)
+static uint32_t SIM_edgeTime[SIM_EDGES];        // queued edges (time, level)
+static uint8_t  SIM_edgeLevel[SIM_EDGES];
+static uint8_t  SIM_edgeHead, SIM_edgeCount;
+static uint8_t  SIM_inISR, SIM_inWait;
+static uint32_t SIM_intfr;                      // pending EXTI flags
+static int      SIM_resets;                     // number of reset flashes
+static jmp_buf  SIM_end;
+
+static void SIM_plan(void);
+static void PLAY_judge(void);
+
+// Queue a button edge (level 0: pressed, 1: released, SIM_PROBE: judge last press)
+#define SIM_PROBE         2
+static void SIM_edge(uint32_t time, uint8_t level) {
+  uint8_t i = (SIM_edgeHead + SIM_edgeCount++) % SIM_EDGES;
+  SIM_edgeTime[i]  = time;
+  SIM_edgeLevel[i] = level;
+}
+
+// Run the pin interrupt if it is pending, enabled and not masked
+static void SIM_deliver(void) {
+  uint32_t bit = (uint32_t)1 << ((PIN_KEY) & 7);
+  while(SIM_mie && !SIM_inISR && (SIM_extiAccess()->INTENR & SIM_intfr & bit) &&
+        (SIM_pfic.IENR[EXTI7_0_IRQn >> 5] & ((uint32_t)1 << (EXTI7_0_IRQn & 31)))) {
+    SIM_now += SIM_ISR_TICKS;
+    SIM_inISR = 1;
+    EXTI7_0_IRQHandler();
+    SIM_inISR = 0;
+  }
+}
+
+// Apply a button edge to pin and EXTI flags
+static void SIM_apply(uint8_t level) {
+  uint32_t bit = (uint32_t)1 << ((PIN_KEY) & 7);
+  uint8_t  old = (SIM_gpio[1].INDR & bit) ? 1 : 0;
+  if(level == SIM_PROBE) PLAY_judge();
+  if(level == old || level == SIM_PROBE) return;
+  if(level) SIM_gpio[1].INDR |= bit;
+  else      SIM_gpio[1].INDR &= ~bit;
+  if((level && (SIM_exti.RTENR & bit)) || (!level && (SIM_exti.FTENR & bit)))
+    SIM_intfr |= bit;
+}
+
+// Get time of the next edge (0: none), planned by the player if the queue is empty
+static uint8_t SIM_next(uint32_t *time) {
+  if(!SIM_edgeCount) SIM_plan();
+  if(!SIM_edgeCount) return 0;
+  *time = SIM_edgeTime[SIM_edgeHead];
+  return 1;
+}
+
+// Let time pass until the given time, applying the edges on the way
+static void SIM_advance(uint32_t until) {
+  uint32_t time;
+  while(SIM_next(&time) && SIM_after(until, time)) {
+    if(SIM_after(time, SIM_now)) SIM_now = time;
+    SIM_apply(SIM_edgeLevel[SIM_edgeHead]);
+    SIM_edgeHead = (SIM_edgeHead + 1) % SIM_EDGES;
+    SIM_edgeCount--;
+    SIM_deliver();
+  }
+  if(SIM_after(until, SIM_now)) SIM_now = until;
+}
+
+// Check if the pin interrupt is pending (wakes up the core even if masked)
+static uint8_t SIM_pending(void) {
+  uint32_t bit = (uint32_t)1 << ((PIN_KEY) & 7);
+  return (SIM_extiAccess()->INTENR & SIM_intfr & bit) ? 1 : 0;
+}
+
+// Sleep until time (if timed) or the next pin interrupt
+static void SIM_sleep(uint8_t timed, uint32_t time) {
+  uint32_t edge;
+  while(!SIM_pending()) {
+    if(!SIM_next(&edge)) longjmp(SIM_end, 1);  // all presses played
+    if(timed && !SIM_after(time, edge)) {
+      SIM_advance(time);
+      break;
+    }
+    SIM_advance(edge);                          // edge sets the interrupt flag
+  }
+  SIM_now += SIM_WAKE_TICKS;
+}
+
+// SysTick access (every access takes a little time and may let an interrupt in)
+static STK_TypeDef *SIM_stkAccess(void) {
+  if(!SIM_inISR) SIM_advance(SIM_now + SIM_STK_TICKS);
+  SIM_stk.CNT = SIM_now;
+  return &SIM_stk;
+}
+
+// EXTI access (INTFR is write-1-to-clear: bits written since the last access clear
+// the pending flags, reads of INTFR are not modeled as neo_hunt only writes it)
+static EXTI_TypeDef *SIM_extiAccess(void) {
+  SIM_intfr     &= ~SIM_exti.INTFR;
+  SIM_exti.INTFR = 0;
+  return &SIM_exti;
+}
+
+// Transmission time of one NeoPixel byte
+static void SIM_sendByte(void) {
+  SIM_advance(SIM_now + SIM_BYTE_TICKS);
+}
+
+// ===================================================================================
+// Simulated Core and System Functions
+// ===================================================================================
+static uint32_t SIM_save(void) {
+  uint32_t save = SIM_mie;
+  SIM_mie = 0;
+  return save;
+}
+
+static void SIM_restore(const uint32_t *save) {
+  SIM_mie = *save;
+  SIM_deliver();
+}
+
+static void SIM_intEnable(void) {
+  SIM_mie = 1;
+  SIM_deliver();
+}
+
+void ALM_init(void) {
+}
+
+void ALM_sleep(uint32_t time) {
+  SIM_sleep(1, time);
+}
+
+void ALM_wait(uint32_t time) {
+  SIM_resets++;                                 // only used by GAME_reset()
+  SIM_inWait = 1;
+  while(!SIM_after(SIM_now, time)) {
+    SIM_sleep(1, time);
+    SIM_deliver();
+  }
+  SIM_inWait = 0;
+}
+
+void SLEEP_WFI_now(void) {
+  SIM_sleep(0, 0);
+}
+
+// Standby is not used by neo_hunt (KEY_sleep is only linked in)
+void STDBY_WFE_now(void) {
+  SIM_sleep(0, 0);
+}
+
+void PWR_save(uint32_t keep) {
+}
+
+void PWR_restore(void) {
+}
+
+// ===================================================================================
+// Simulated Player
+// ===================================================================================
+enum{PLAY_CATCH, PLAY_BOUNCE, PLAY_EARLY, PLAY_LONG, PLAY_DOUBLE, PLAY_EDGE, PLAY_RESET,
+     PLAY_KINDS};
+
+static const char *PLAY_name[PLAY_KINDS] = {
+  "catch", "bouncing catch", "early press", "long press", "double-click",
+  "catch at step boundary", "during reset"
+};
+
+static int      PLAY_total = 300;               // presses to play
+static int      PLAY_count, PLAY_wrong;         // presses played, misjudged
+static int      PLAY_aimed;                     // presses aimed at the deer
+static int      PLAY_kind  = -1;                // kind of last press
+static uint32_t PLAY_speed;                     // hunter speed before last press
+static uint32_t PLAY_leave;                     // time the hunter leaves the deer
+static int      PLAY_resets;                    // reset flashes before last press
+static uint32_t PLAY_seed  = 1;                 // pseudo-random offsets
+
+static uint32_t PLAY_random(uint32_t range) {
+  PLAY_seed = PLAY_seed * 1103515245 + 12345;
+  return (PLAY_seed >> 16) % range;
+}
+
+// Check the outcome of the last press (probe shortly after the decision)
+static void PLAY_judge(void) {
+  uint8_t caught = (SIM_resets == PLAY_resets) &&
+                   (speed == PLAY_speed - GAME_SPEED_INC * DLY_MS_TIME);
+  uint8_t missed = (SIM_resets == PLAY_resets + 1);
+  uint8_t ok;
+  switch(PLAY_kind) {
+    case PLAY_EARLY:  ok = missed; break;
+    case PLAY_EDGE:   ok = ((int32_t)(KEY_time() - PLAY_leave) < 0) ? caught : missed;
+                      break;                    // judged by the edge timestamp
+    case PLAY_RESET:  ok = (SIM_resets == PLAY_resets) &&    // press ignored
+                           (speed == GAME_SPEED_START * DLY_MS_TIME);
+                      break;
+    default:          ok = caught; break;
+  }
+  if(!ok) {
+    PLAY_wrong++;
+    printf("Press %d (%s) misjudged at %u\n", PLAY_count, PLAY_name[PLAY_kind], SIM_now);
+  }
+}
+
+// Queue a press with optional bounces, probe the outcome, release after hold ticks
+static void PLAY_press(uint32_t time, uint32_t hold, uint32_t probe, uint8_t bounce) {
+  SIM_edge(time, 0);
+  if(bounce) {
+    SIM_edge(time +  400, 1);
+    SIM_edge(time +  900, 0);
+    SIM_edge(time + 2000, 1);
+    SIM_edge(time + 4000, 0);
+  }
+  if(probe && (probe < hold)) SIM_edge(time + probe, SIM_PROBE);
+  SIM_edge(time + hold, 1);
+  if(probe && (probe >= hold)) SIM_edge(time + probe, SIM_PROBE);
+}
+
+// Plan the next press from the game state (called when the edge queue is empty)
+static void SIM_plan(void) {
+  uint32_t steps, start, press, probe = SCHED_MS(20);
+  if(PLAY_count >= PLAY_total) return;
+  PLAY_speed  = speed;
+  PLAY_resets = SIM_resets;
+  if(SIM_inWait) {                              // blue reset flash running:
+    PLAY_kind = PLAY_RESET;                     // press must be ignored
+    PLAY_press(SIM_now + SCHED_MS(5), SCHED_MS(10), SCHED_MS(150), 0);
+    PLAY_count++;
+    return;
+  }
+  if(!speed) {                                  // game not started yet
+    SIM_edge(SIM_now + SCHED_MS(1), 1);
+    return;
+  }
+  PLAY_kind = (PLAY_aimed % 16 == 15) ? PLAY_EARLY : PLAY_aimed % PLAY_RESET;
+  steps = (dir ? deer - hunter : hunter - deer) & 15;
+  start = steps ? due + (steps - 1) * speed : moved;  // hunter reaches deer
+  press = start + speed / 8 + PLAY_random(speed * 3 / 4);
+  if(PLAY_kind == PLAY_EARLY) press -= speed;   // one step before the deer
+  if(PLAY_kind == PLAY_EDGE) {                  // a few us after the hunter arrived
+    press = PLAY_random(32) + SIM_ISR_TICKS;    // or before it leaves the deer
+    press = (PLAY_aimed / PLAY_RESET) & 1 ? start + press : start + speed - press;
+    PLAY_leave = start + speed;
+  }
+  if(!SIM_after(press, SIM_now + SCHED_MS(1))) {
+    PLAY_kind = -1;                             // too late to aim, plan again later
+    SIM_edge(SIM_now + speed, 1);
+    return;
+  }
+  switch(PLAY_kind) {
+    case PLAY_BOUNCE: PLAY_press(press, SCHED_MS(60), probe, 1); break;
+    case PLAY_LONG:   PLAY_press(press, SCHED_MS(KEY_LONG_MS + 50), probe, 0); break;
+    case PLAY_DOUBLE: PLAY_press(press, SCHED_MS(40), probe, 0);
+                      PLAY_press(press + SCHED_MS(120), SCHED_MS(40), 0, 0);
+                      break;
+    default:          PLAY_press(press, SCHED_MS(80), probe, 0); break;
+  }
+  PLAY_aimed++;
+  PLAY_count++;
+}
+
+// ===================================================================================
+// Main Function
+// ===================================================================================
+int main(int argc, char **argv) {
+  static const char *name[LAT_CHANNELS] = {"wake-up to frame", "edge to decision",
+                                           "edge to frame"};
+  uint8_t failed;
+  if(argc > 1) PLAY_total = atoi(argv[1]);
+  SIM_gpio[1].INDR = 0xFF;                      // button released (pull-up)
+
+  if(!setjmp(SIM_end)) HUNT_main();             // play until the script is over
+
+  failed = LAT_failed();
+  printf("%-18s %8s %8s %8s %8s %8s\n", "channel", "count", "min/us", "avg/us",
+         "max/us", "limit/us");
+  for(uint8_t i=0; i<LAT_CHANNELS; i++) {
+    volatile LAT_stat_t *s = &LAT_stat[i];
+    printf("%-18s %8u %8.1f %8.1f %8.1f %8.1f%s\n", name[i], s->count,
+           s->count ? s->min / (double)DLY_US_TIME : 0,
+           s->count ? s->sum / (double)s->count / DLY_US_TIME : 0,
+           s->max / (double)DLY_US_TIME, s->limit / (double)DLY_US_TIME,
+           (failed & (1 << i)) ? "  LIMIT EXCEEDED" : "");
+  }
+  printf("hunt_sim: %d presses, %d misjudged, %s\n", PLAY_count, PLAY_wrong,
+         (failed || PLAY_wrong) ? "FAILED" : "passed");
+  return (failed || PLAY_wrong) ? 1 : 0;
+}
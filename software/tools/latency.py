@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# ===================================================================================
+# Project:   TinyBling - Latency Report
+# Version:   v1.0
+# Year:      2024
+# Author:    Stefan Wagner
+# Github:    https://github.com/wagiminator
+# License:   http://creativecommons.org/licenses/by-sa/3.0/
+# ===================================================================================
+#
+# Description:
+# ------------
+# Evaluates the latency statistics (LAT_stat, see lat.h) recorded on the target by
+# neo_demo, neo_hunt or neo_wof. Play the game (or let the demo run) for a while,
+# halt the MCU with the debugger and save the memory of LAT_stat (address see the
+# .map file created by 'make all', size LAT_SIZE bytes) to a binary file, or copy
+# the 32-bit words shown by the debugger into a text file. The report shows
+# minimum, average and maximum latency as well as the histogram of each channel.
+# The exit code is 1 if any channel has exceeded its limit (LAT_LIMIT_* in lat.h),
+# so the script can be used to catch responsiveness regressions.
+#
+# Usage:
+# ------
+# python3 latency.py lat_stat.bin
+# python3 latency.py --hex lat_stat.txt --f-cpu 8000000
+
+import argparse
+import struct
+import sys
+
+# ===================================================================================
+# LAT_stat Layout (must match lat.h)
+# ===================================================================================
+F_CPU     = 8000000                             # SysTick frequency in Hz
+LAT_BINS  = 8                                   # number of histogram bins
+LAT_SHIFT = 6                                   # LAT_BIN_SHIFT
+CHANNELS  = ['wake-up to frame', 'edge to decision', 'edge to frame']
+FORMAT    = '<5I%dH' % LAT_BINS                 # min, max, sum, count, limit, hist
+LAT_SIZE  = struct.calcsize(FORMAT) * len(CHANNELS)
+
+def load(filename, hexwords):
+  if not hexwords:
+    with open(filename, 'rb') as f: return f.read()
+  data = b''
+  with open(filename) as f:
+    for line in f:
+      for word in line.split(':')[-1].split():
+        data += struct.pack('<I', int(word, 16))
+  return data
+
+def main():
+  parser = argparse.ArgumentParser(description='TinyBling latency report')
+  parser.add_argument('file',                                help='memory dump of LAT_stat')
+  parser.add_argument('--hex',   action='store_true',        help='file contains hex words')
+  parser.add_argument('--f-cpu', type=int, default=F_CPU,    help='SysTick frequency in Hz')
+  args = parser.parse_args()
+
+  data = load(args.file, args.hex)
+  if len(data) < LAT_SIZE:
+    sys.exit('Dump too short: %d bytes, expected %d' % (len(data), LAT_SIZE))
+
+  us     = 1e6 / args.f_cpu
+  failed = False
+  size   = struct.calcsize(FORMAT)
+  print('%-18s %8s %8s %8s %8s %8s' % ('', 'count', 'min us', 'avg us', 'max us', 'limit'))
+  for i, name in enumerate(CHANNELS):
+    val = struct.unpack_from(FORMAT, data, i * size)
+    low, high, total, count, limit = val[:5]
+    hist = val[5:]
+    if not count:
+      print('%-18s %8d' % (name, 0))
+      continue
+    over = high > limit
+    failed |= over
+    print('%-18s %8d %8.1f %8.1f %8.1f %8.1f %s' % (name, count, low * us,
+          total / count * us, high * us, limit * us, 'FAIL' if over else 'ok'))
+    for b, n in enumerate(hist):
+      if not n: continue
+      lo = 0 if not b else (1 << (LAT_SHIFT + b - 1)) * us
+      hi = (1 << (LAT_SHIFT + b)) * us
+      bar = '#' * max(1, round(40 * n / max(hist)))
+      if b < LAT_BINS - 1: print('  %7.0f - %7.0f us %6d %s' % (lo, hi, n, bar))
+      else:                print('  %7.0f us and more %6d %s' % (lo, n, bar))
+  sys.exit(1 if failed else 0)
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,158 @@
+// ===================================================================================
+// Project:   TinyBling - Host Benchmark of the Pixel Ring Rotation
+// Version:   v1.0
+// Year:      2024
+// Author:    Stefan Wagner
+// Github:    https://github.com/wagiminator
+// License:   http://creativecommons.org/licenses/by-sa/3.0/
+// ===================================================================================
+//
+// Description:
+// ------------
+// Compares the two ways to circle the pixels of a ring by one position per frame
+// for 16 to 1024 pixels:
+// - offset: neo_demo's way, NEO_cw() only moves the rotation offset NEO_start,
+//   every pixel access goes through NEO_index() and NEO_show() reads the buffer in
+//   two parts starting at the offset.
+// - shift:  the buffer itself is shifted by one entry (hue and brightness), pixel
+//   accesses and the read-out use the plain index.
+// A frame rotates the ring, adds a few particles (NEO_add) and reads all entries
+// in pixel order like NEO_show() does (without sending). The table shows the host
+// time of the rotation alone and of the whole frame. The code mirrors main.c with
+// 16-bit indices, only relative values are meaningful.
+//
+// Usage:
+// ------
+// make -C software/tools bench
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BENCH_MAX         1024                  // largest ring
+#define BENCH_FRAMES      20000                 // frames per ring size
+#define BENCH_ADDS        8                     // NEO_add() calls per frame
+
+static uint8_t  NEO_hue[BENCH_MAX];
+static uint8_t  NEO_bright[BENCH_MAX];
+static uint16_t NEO_count;                      // number of pixels
+static uint16_t NEO_start;                      // buffer index of first pixel
+static volatile uint32_t BENCH_sink;            // keeps the read-out alive
+
+// Host time in ns
+static uint64_t BENCH_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Stand-in for NEO_writePixel() (sending is left out)
+static inline uint32_t BENCH_pixel(uint16_t i) {
+  return NEO_hue[i] ^ NEO_bright[i];
+}
+
+// ===================================================================================
+// Rotation by Offset (neo_demo)
+// ===================================================================================
+static inline uint16_t OFS_index(uint16_t number) {
+  number += NEO_start;
+  return (number >= NEO_count) ? (number - NEO_count) : number;
+}
+
+static void OFS_cw(void) {
+  NEO_start = (NEO_start ? NEO_start : NEO_count) - 1;
+}
+
+static void OFS_add(uint16_t number, uint8_t hue, uint8_t bright) {
+  number = OFS_index(number);
+  if(bright > NEO_bright[number]) NEO_hue[number] = hue;
+  bright += NEO_bright[number];
+  NEO_bright[number] = (bright > 6) ? 6 : bright;
+}
+
+static void OFS_show(void) {
+  uint32_t sum = 0;
+  uint16_t i;
+  for(i=NEO_start; i<NEO_count; i++) sum += BENCH_pixel(i);
+  for(i=0; i<NEO_start; i++) sum += BENCH_pixel(i);
+  BENCH_sink = sum;
+}
+
+// ===================================================================================
+// Rotation by Shifting the Buffer
+// ===================================================================================
+static void SHIFT_cw(void) {
+  uint8_t  hue = NEO_hue[0], bright = NEO_bright[0];
+  uint16_t i;
+  for(i=0; i<NEO_count-1; i++) {
+    NEO_hue[i]    = NEO_hue[i+1];
+    NEO_bright[i] = NEO_bright[i+1];
+  }
+  NEO_hue[i]    = hue;
+  NEO_bright[i] = bright;
+}
+
+static void SHIFT_add(uint16_t number, uint8_t hue, uint8_t bright) {
+  if(bright > NEO_bright[number]) NEO_hue[number] = hue;
+  bright += NEO_bright[number];
+  NEO_bright[number] = (bright > 6) ? 6 : bright;
+}
+
+static void SHIFT_show(void) {
+  uint32_t sum = 0;
+  for(uint16_t i=0; i<NEO_count; i++) sum += BENCH_pixel(i);
+  BENCH_sink = sum;
+}
+
+// ===================================================================================
+// Benchmark
+// ===================================================================================
+typedef struct {
+  void (*cw)(void);
+  void (*add)(uint16_t number, uint8_t hue, uint8_t bright);
+  void (*show)(void);
+} BENCH_ring_t;
+
+static const BENCH_ring_t BENCH_ofs   = {OFS_cw,   OFS_add,   OFS_show};
+static const BENCH_ring_t BENCH_shift = {SHIFT_cw, SHIFT_add, SHIFT_show};
+
+// Run frames on a ring of n pixels, return ns per rotation and per frame
+static void BENCH_run(const BENCH_ring_t *ring, uint16_t n, double *rot, double *frame) {
+  uint32_t seed = 1, f;
+  uint64_t start;
+  NEO_count = n;
+  NEO_start = 0;
+  for(uint16_t i=0; i<n; i++) NEO_hue[i] = i, NEO_bright[i] = i % 7;
+  start = BENCH_ns();                           // rotations alone
+  for(f=0; f<BENCH_FRAMES; f++) {
+    ring->cw();
+    BENCH_sink = NEO_start ^ NEO_hue[0];
+  }
+  *rot  = (double)(BENCH_ns() - start) / BENCH_FRAMES;
+  start = BENCH_ns();                           // whole frames
+  for(f=0; f<BENCH_FRAMES; f++) {
+    ring->cw();
+    for(uint8_t a=0; a<BENCH_ADDS; a++) {
+      seed = seed * 1103515245 + 12345;
+      ring->add((seed >> 16) % n, seed >> 8, 1);
+    }
+    ring->show();
+  }
+  *frame = (double)(BENCH_ns() - start) / BENCH_FRAMES;
+}
+
+// ===================================================================================
+// Main Function
+// ===================================================================================
+int main(void) {
+  double orot, oframe, srot, sframe;
+  printf("%8s %12s %12s %12s %12s\n", "pixels", "offset-cw/ns", "offset-fr/ns",
+         "shift-cw/ns", "shift-fr/ns");
+  for(uint16_t n=16; n<=BENCH_MAX; n<<=1) {
+    BENCH_run(&BENCH_ofs,   n, &orot, &oframe);
+    BENCH_run(&BENCH_shift, n, &srot, &sframe);
+    printf("%8u %12.1f %12.1f %12.1f %12.1f\n", n, orot, oframe, srot, sframe);
+  }
+  printf("frame: rotation, %u NEO_add() and read-out of all pixels\n", BENCH_ADDS);
+  return 0;
+}
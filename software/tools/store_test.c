@@ -0,0 +1,232 @@
+// ===================================================================================
+// Project:   TinyBling - Host Test of the Flash Record Store
+// Version:   v1.0
+// Year:      2024
+// Author:    Stefan Wagner
+// Github:    https://github.com/wagiminator
+// License:   http://creativecommons.org/licenses/by-sa/3.0/
+// ===================================================================================
+//
+// Description:
+// ------------
+// Builds neo_demo's store.c on the host against a simulated flash. The store pages
+// are mapped to their real address (end of the 16K flash), the FLASH registers are
+// replaced by a model that evaluates each register access: unlock keys, lock bits,
+// page erase and half-word programming. Like the real flash, a half-word can only
+// be programmed once after an erase. A power loss is simulated by a budget of
+// flash operations, after which all further erases and writes are lost.
+// The test covers blank flash, sequence number wrap, page switches, writes torn
+// by a power loss and corrupted records, with both erased patterns (0xFF and the
+// CH32V003's 0xE339). The exit code is 1 if any check fails.
+//
+// Usage:
+// ------
+// make -C software/tools test
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "../neo_demo/src/store.h"
+
+// ===================================================================================
+// Flash Simulation
+// ===================================================================================
+static FLASH_TypeDef SIM_regs;                  // register file seen by the store
+static uint16_t *SIM_mem;                       // store pages at their real address
+static uint16_t SIM_shadow[STORE_SIZE / 2];     // programmed flash content
+static uint16_t SIM_blank;                      // erased half-word pattern
+static uint8_t  SIM_locked, SIM_flocked;        // lock states
+static uint8_t  SIM_key, SIM_modekey;           // unlock sequence states
+static int      SIM_budget;                     // flash operations until power loss
+static int      SIM_errors;                     // illegal accesses
+static int      SIM_erases[STORE_PAGES];        // erase count per page
+
+// Evaluate the register accesses made since the last call (called on every access)
+static FLASH_TypeDef *SIM_flash(void) {
+  // Lock bits and unlock sequences (unlocking clears the lock bit)
+  if(SIM_regs.CTLR & FLASH_CTLR_LOCK)  SIM_locked  = 1;
+  if(SIM_regs.CTLR & FLASH_CTLR_FLOCK) SIM_flocked = 1;
+  if(SIM_regs.KEYR == FLASH_KEY1) SIM_key = 1;
+  else if((SIM_regs.KEYR == FLASH_KEY2) && SIM_key) {
+    SIM_locked = SIM_key = 0;
+    SIM_regs.CTLR &= ~FLASH_CTLR_LOCK;
+  }
+  else if(SIM_regs.KEYR) SIM_key = 0;
+  SIM_regs.KEYR = 0;
+  if(SIM_regs.MODEKEYR == FLASH_KEY1) SIM_modekey = 1;
+  else if((SIM_regs.MODEKEYR == FLASH_KEY2) && SIM_modekey) {
+    SIM_flocked = SIM_modekey = 0;
+    SIM_regs.CTLR &= ~FLASH_CTLR_FLOCK;
+  }
+  else if(SIM_regs.MODEKEYR) SIM_modekey = 0;
+  SIM_regs.MODEKEYR = 0;
+
+  // Page erase
+  if((SIM_regs.CTLR & (FLASH_CTLR_PAGE_ER | FLASH_CTLR_STRT))
+                   == (FLASH_CTLR_PAGE_ER | FLASH_CTLR_STRT)) {
+    uint32_t offset = SIM_regs.ADDR - STORE_START;
+    SIM_regs.CTLR &= ~FLASH_CTLR_STRT;
+    if(!SIM_budget);                            // power lost: MCU is dead
+    else if(SIM_locked || SIM_flocked || (offset >= STORE_SIZE) ||
+       (offset & (STORE_PAGE_SIZE - 1))) SIM_errors++;
+    else {
+      SIM_budget--;
+      SIM_erases[offset / STORE_PAGE_SIZE]++;
+      for(uint32_t i=0; i<STORE_PAGE_SIZE/2; i++)
+        SIM_shadow[offset / 2 + i] = SIM_mem[offset / 2 + i] = SIM_blank;
+    }
+  }
+
+  // Half-word programming (memory writes since the last call)
+  for(uint32_t i=0; i<STORE_SIZE/2; i++) {
+    if(SIM_mem[i] == SIM_shadow[i]) continue;
+    if(!SIM_budget);                            // power lost: MCU is dead
+    else if(!(SIM_regs.CTLR & FLASH_CTLR_PG) || SIM_locked || (SIM_shadow[i] != SIM_blank))
+      SIM_errors++;                             // write without programming or twice
+    else {
+      SIM_budget--;
+      SIM_shadow[i] = SIM_mem[i];
+      continue;
+    }
+    SIM_mem[i] = SIM_shadow[i];                 // write is lost
+  }
+  return &SIM_regs;
+}
+
+// Build the store against the simulation
+#undef  FLASH
+#define FLASH (SIM_flash())
+#include "../neo_demo/src/store.c"
+
+// Erase all store pages (fresh device)
+static void SIM_format(uint16_t blank) {
+  SIM_blank = blank;
+  for(uint32_t i=0; i<STORE_SIZE/2; i++) SIM_shadow[i] = SIM_mem[i] = blank;
+  memset(&SIM_regs, 0, sizeof(SIM_regs));
+  SIM_regs.CTLR = FLASH_CTLR_LOCK | FLASH_CTLR_FLOCK;
+  SIM_locked = SIM_flocked = 1;
+  SIM_key = SIM_modekey = 0;
+  SIM_budget = -1;
+  SIM_errors = 0;
+  memset(SIM_erases, 0, sizeof(SIM_erases));
+}
+
+// Restart the firmware: reset the static store state and read the newest record
+static uint8_t SIM_boot(uint8_t *data) {
+  SIM_budget = -1;                              // power is back
+  STORE_slot = STORE_SLOTS - 1;
+  STORE_seq  = 0;
+  return STORE_read(data);
+}
+
+// ===================================================================================
+// Test Functions
+// ===================================================================================
+static int fails;
+
+#define CHECK(cond, ...) do { if(!(cond)) { \
+  fails++; printf("FAIL (blank %04X) line %d: ", SIM_blank, __LINE__); \
+  printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+// Write one record from a number
+static void TEST_write(int n) {
+  uint8_t data[2] = {n, n >> 8};
+  STORE_write(data);
+}
+
+// Check that a reboot finds the record of a number
+static void TEST_expect(int n, const char *what) {
+  uint8_t data[2] = {0, 0};
+  uint8_t found = SIM_boot(data);
+  CHECK(found && (data[0] == (uint8_t)n) && (data[1] == (uint8_t)(n >> 8)),
+        "%s: expected record %d, found %d (%02X %02X)", what, n, found, data[0], data[1]);
+}
+
+// Blank flash: no record, first write erases the first page only
+static void TEST_blank(uint16_t blank) {
+  uint8_t data[2];
+  SIM_format(blank);
+  CHECK(!SIM_boot(data), "blank flash returned a record");
+  TEST_write(1);
+  TEST_expect(1, "first write");
+  CHECK((SIM_erases[0] == 1) && (SIM_erases[1] == 0), "first write erased %d/%d pages",
+        SIM_erases[0], SIM_erases[1]);
+  CHECK(!SIM_errors, "%d illegal flash accesses", SIM_errors);
+}
+
+// Sequence number wrap and page switches over many writes with reboots in between
+static void TEST_wrap(uint16_t blank) {
+  const int writes = 20 * STORE_SLOTS + 7;      // several sequence number wraps
+  SIM_format(blank);
+  SIM_boot((uint8_t[2]){0});
+  for(int n=0; n<writes; n++) {
+    TEST_write(n);
+    TEST_expect(n, "wrap");
+  }
+  for(int p=0; p<STORE_PAGES; p++) {
+    int first    = p * STORE_PAGE_SIZE / 4;     // first slot of page
+    int expected = (writes - first + STORE_SLOTS - 1) / STORE_SLOTS;
+    CHECK(SIM_erases[p] == expected, "page %d erased %d times, expected %d",
+          p, SIM_erases[p], expected);
+  }
+  CHECK(!SIM_errors, "%d illegal flash accesses", SIM_errors);
+}
+
+// Power loss after each flash operation of a write, at each slot position
+static void TEST_torn(uint16_t blank) {
+  for(int pos=0; pos<2*STORE_SLOTS; pos++) {
+    for(int budget=0; budget<3; budget++) {
+      int ops;
+      SIM_format(blank);
+      SIM_boot((uint8_t[2]){0});
+      for(int n=0; n<=pos; n++) TEST_write(n);  // newest record: pos
+      ops = (STORE_slot + 1) % (STORE_PAGE_SIZE / 4) ? 2 : 3;
+      SIM_budget = budget;
+      TEST_write(1000);                         // torn write
+      TEST_expect((budget >= ops) ? 1000 : pos, "torn write");
+      TEST_write(2000);                         // next write after reboot
+      TEST_expect(2000, "write after torn write");
+      TEST_write(3000);
+      TEST_expect(3000, "second write after torn write");
+      CHECK(!SIM_errors, "pos %d budget %d: %d illegal flash accesses",
+            pos, budget, SIM_errors);
+    }
+  }
+}
+
+// Corrupted newest record: fall back to the one before
+static void TEST_corrupt(uint16_t blank) {
+  SIM_format(blank);
+  SIM_boot((uint8_t[2]){0});
+  for(int n=0; n<5; n++) TEST_write(n);
+  SIM_shadow[STORE_slot * 2] = SIM_mem[STORE_slot * 2] ^= 0x0100;  // flip a data bit
+  TEST_expect(3, "corrupt record");
+  TEST_write(5);
+  TEST_expect(5, "write after corrupt record");
+  CHECK(!SIM_errors, "%d illegal flash accesses", SIM_errors);
+}
+
+// ===================================================================================
+// Main Function
+// ===================================================================================
+int main(void) {
+  static const uint16_t blanks[] = {0xFFFF, STORE_BLANK & 0xFFFF};
+  long page = 4096;
+  uintptr_t base = STORE_START & ~(uintptr_t)(page - 1);
+  void *map = mmap((void*)base, page, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if(map != (void*)base) {
+    printf("Cannot map simulated flash at 0x%08lX\n", (unsigned long)base);
+    return 1;
+  }
+  SIM_mem = (uint16_t*)(uintptr_t)STORE_START;
+
+  for(unsigned i=0; i<sizeof(blanks)/sizeof(blanks[0]); i++) {
+    TEST_blank(blanks[i]);
+    TEST_wrap(blanks[i]);
+    TEST_torn(blanks[i]);
+    TEST_corrupt(blanks[i]);
+  }
+  printf("store_test: %s (%d failures)\n", fails ? "FAILED" : "passed", fails);
+  return fails ? 1 : 0;
+}
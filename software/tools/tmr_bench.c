@@ -0,0 +1,132 @@
+// ===================================================================================
+// Project:   TinyBling - Host Benchmark of the Software Timer Wheel
+// Version:   v1.0
+// Year:      2024
+// Author:    Stefan Wagner
+// Github:    https://github.com/wagiminator
+// License:   http://creativecommons.org/licenses/by-sa/3.0/
+// ===================================================================================
+//
+// Description:
+// ------------
+// Builds neo_demo's tmr.c with the native compiler (pool enlarged to BENCH_POOL
+// timers) and runs the wheel with an increasing number of timers. The scheduler is
+// replaced by a simulated SysTick that jumps to the next wheel step, the time within
+// a step is the real host time scaled to SysTick ticks. One periodic timer expires
+// on every wheel step, all other timers are spread over the buckets and only expire
+// after the run, so the number of expired timers per step stays at one and the
+// table shows the bookkeeping cost of the running timers alone. The callback burns
+// BENCH_CALL_US on purpose, which must not show up in TMR_stat.max. For each timer
+// count the table shows the average host time per wheel step (with and without the
+// callback), the average number of expired timers per step and TMR_stat.max. Only
+// relative values are meaningful: the cost per step grows with the bucket size
+// (timers / TMR_SLOTS).
+//
+// Usage:
+// ------
+// make -C software/tools bench
+
+#define TMR_POOL          BENCH_POOL
+
+#include <stdio.h>
+#include <time.h>
+#include "../neo_demo/src/ch32v003.h"
+
+// ===================================================================================
+// Simulated SysTick and Scheduler
+// ===================================================================================
+#define BENCH_POOL        250                   // timers in pool
+#define BENCH_STEPS       20000                 // wheel steps per timer count
+#define BENCH_CALL_US     20                    // host time burnt per callback
+
+static STK_TypeDef SIM_stk;
+static uint32_t    SIM_now;                     // SysTick time at start of step
+static uint64_t    SIM_base;                    // host time at start of step in ns
+static STK_TypeDef *SIM_stkAccess(void);
+
+#undef  STK
+#define STK               (SIM_stkAccess())
+
+#include "../neo_demo/config.h"
+#include "../neo_demo/src/system.h"
+#include "../neo_demo/src/sched.h"
+
+static SCHED_func_t SIM_task;                   // wheel task
+static uint32_t     SIM_due;                    // SysTick time of next wheel step
+static uint8_t      SIM_running;                // 1: wheel task scheduled
+
+void SCHED_set(uint8_t id, SCHED_func_t func) { SIM_task = func; }
+void SCHED_at(uint8_t id, uint32_t time)      { SIM_due  = time; SIM_running = 1; }
+void SCHED_stop(uint8_t id)                   { SIM_running = 0; }
+
+#include "../neo_demo/src/tmr.c"
+
+// Host time in ns
+static uint64_t SIM_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// SysTick access: time of the step plus host time elapsed since then
+static STK_TypeDef *SIM_stkAccess(void) {
+  SIM_stk.CNT = SIM_now + (uint32_t)((SIM_ns() - SIM_base) * DLY_US_TIME / 1000);
+  return &SIM_stk;
+}
+
+// Jump to time (start of a new step)
+static void SIM_jump(uint32_t time) {
+  SIM_now  = time;
+  SIM_base = SIM_ns();
+}
+
+// ===================================================================================
+// Benchmark
+// ===================================================================================
+static uint32_t BENCH_fired;                    // callbacks run
+static uint64_t BENCH_callNs;                   // host time spent in callbacks
+
+// Timer callback: burn some time
+static void BENCH_call(void) {
+  uint64_t start = SIM_ns();
+  while(SIM_ns() - start < BENCH_CALL_US * 1000);
+  BENCH_callNs += SIM_ns() - start;
+  BENCH_fired++;
+}
+
+// Run the wheel with one timer expiring every step and n - 1 waiting timers
+static void BENCH_run(uint16_t n) {
+  uint32_t seed = 1, steps;
+  uint64_t start, total = 0;
+  SIM_jump(0);
+  TMR_init(0);
+  TMR_every(TMR_new(BENCH_call), 1);
+  for(uint16_t i=1; i<n; i++) {
+    seed = seed * 1103515245 + 12345;
+    TMR_in(TMR_new(BENCH_call), BENCH_STEPS + 1 + (seed >> 16) % TMR_SLOTS);
+  }
+  BENCH_fired  = 0;
+  BENCH_callNs = 0;
+  for(steps=0; SIM_running && (steps < BENCH_STEPS); steps++) {
+    SIM_jump(SIM_due);
+    start  = SIM_ns();
+    SIM_task();
+    total += SIM_ns() - start;
+  }
+  printf("%8u %10.0f %10.0f %10.2f %10u\n", n,
+         (double)total / steps, (double)(total - BENCH_callNs) / steps,
+         (double)BENCH_fired / steps, TMR_stat.max);
+}
+
+// ===================================================================================
+// Main Function
+// ===================================================================================
+int main(void) {
+  static const uint16_t counts[] = {1, 2, 4, 8, 16, 32, 64, 128, BENCH_POOL};
+  printf("%8s %10s %10s %10s %10s\n", "timers", "step/ns", "wheel/ns", "fired",
+         "max/ticks");
+  for(unsigned i=0; i<sizeof(counts)/sizeof(counts[0]); i++) BENCH_run(counts[i]);
+  printf("callbacks burn %uus (%u ticks) each, not counted in max/ticks\n",
+         BENCH_CALL_US, BENCH_CALL_US * DLY_US_TIME);
+  return 0;
+}